@@ -0,0 +1,347 @@
+#ifndef MY_ALLOCATOR_H_GUARD
+#define MY_ALLOCATOR_H_GUARD
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace alloc_detail
+{
+    template <typename Alloc, typename T>
+    using Rebind = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+
+    // узел через распределитель; узлы - агрегаты и строятся фигурными
+    // скобками, поэтому не через allocator_traits::construct
+    template <typename Alloc, typename... Ts>
+    auto new_object (Alloc& alloc, Ts&&... params) {
+        using Traits = std::allocator_traits<Alloc>;
+        using T = typename Traits::value_type;
+
+        T* ptr = Traits::allocate (alloc, 1);
+        try {
+            return new (ptr) T {std::forward<Ts> (params)...};
+        } catch (...) {
+            Traits::deallocate (alloc, ptr, 1);
+            throw;
+        }
+    }
+
+
+    template <typename Alloc, typename T>
+    void delete_object (Alloc& alloc, T* ptr) noexcept {
+        ptr->~T();
+        std::allocator_traits<Alloc>::deallocate (alloc, ptr, 1);
+    }
+
+
+    // память одного распределителя можно вернуть через другой
+    template <typename Alloc>
+    bool interchangeable (Alloc const& lhs, Alloc const& rhs) noexcept {
+        if constexpr (std::allocator_traits<Alloc>::is_always_equal::value) {
+            return true;
+        } else {
+            return lhs == rhs;
+        }
+    }
+
+
+    // перемещающее присваивание может забрать память rhs: распределители
+    // равны или переходят к приёмнику вместе с памятью (при обмене)
+    template <typename Alloc>
+    bool can_take_storage (Alloc const& lhs, Alloc const& rhs) noexcept {
+        using Traits = std::allocator_traits<Alloc>;
+
+        if constexpr (Traits::propagate_on_container_move_assignment::value
+                  and Traits::propagate_on_container_swap::value) {
+            return true;
+        } else {
+            return interchangeable (lhs, rhs);
+        }
+    }
+
+
+    // распределитель, с которым строится копия при присваивании
+    template <typename Alloc>
+    Alloc const& for_copy_assign (Alloc const& lhs, Alloc const& rhs) noexcept {
+        if constexpr (std::allocator_traits<Alloc>::propagate_on_container_copy_assignment::value) {
+            return rhs;
+        } else {
+            return lhs;
+        }
+    }
+
+
+    // без propagate_on_container_swap распределители обязаны быть равны,
+    // и обмен содержимым их не трогает
+    template <typename Alloc>
+    void swap (Alloc& lhs, Alloc& rhs) noexcept {
+        if constexpr (std::allocator_traits<Alloc>::propagate_on_container_swap::value) {
+            using std::swap;
+            swap (lhs, rhs);
+        }
+    }
+
+
+    template <typename Alloc>
+    Alloc select_for_copy (Alloc const& alloc) {
+        return std::allocator_traits<Alloc>::select_on_container_copy_construction (alloc);
+    }
+
+
+    template <typename Alloc, typename = void>
+    struct HasLazyState : std::false_type {};
+
+
+    template <typename Alloc>
+    struct HasLazyState<Alloc, std::void_t<decltype (std::declval<Alloc&>().share())>>
+        : std::true_type
+    {};
+
+
+    // перед тем как раздать копии alloc частям контейнера: распределитель,
+    // создающий общее состояние при первой аллокации (NodePoolAllocator),
+    // создаёт его сразу, иначе каждая часть завела бы своё
+    template <typename Alloc>
+    void share (Alloc& alloc) {
+        if constexpr (HasLazyState<Alloc>::value) {
+            alloc.share();
+        }
+    }
+}
+
+
+namespace data_struct
+{
+    // монотонная арена: память выдаётся подряд из блоков, deallocate
+    // ничего не делает, release() (и деструктор) отдаёт все блоки разом.
+    // Контейнер в арене можно не разрушать поэлементно, если у элементов
+    // тривиальные деструкторы: достаточно release(). Не потокобезопасна
+    class ArenaResource : public std::pmr::memory_resource {
+        struct Block {
+            Block* prev;
+            std::size_t size;
+        };
+
+        static constexpr std::size_t minBlock = 4096;
+        static constexpr std::size_t maxBlock = std::size_t (1) << 24;
+
+    public:
+        explicit ArenaResource (std::pmr::memory_resource* upstream_ = std::pmr::get_default_resource()) noexcept
+            : upstream (upstream_)
+        {}
+
+        // сначала расходуется buffer вызывающего, он не освобождается
+        ArenaResource (void* buffer, std::size_t size, std::pmr::memory_resource* upstream_ = std::pmr::get_default_resource()) noexcept
+            : upstream (upstream_)
+            , initial (static_cast<char*> (buffer))
+            , initialSize (size)
+            , cur (initial)
+            , left (size)
+        {}
+
+        ArenaResource (ArenaResource const&) = delete;
+        ArenaResource& operator= (ArenaResource const&) = delete;
+
+        ~ArenaResource() override {
+            release();
+        }
+
+        void release() noexcept {
+            while (last) {
+                auto prev = last->prev;
+                upstream->deallocate (last, last->size, alignof(std::max_align_t));
+                last = prev;
+            }
+
+            cur = initial;
+            left = initialSize;
+            nextBlock = minBlock;
+        }
+
+        std::pmr::memory_resource* upstream_resource() const noexcept {
+            return upstream;
+        }
+
+    protected:
+        void* do_allocate (std::size_t bytes, std::size_t align) override {
+            void* ptr = cur;
+            if (std::align (align, bytes, ptr, left) == nullptr) {
+                add_block (bytes + align);
+                ptr = cur;
+                std::align (align, bytes, ptr, left);
+            }
+
+            cur = static_cast<char*> (ptr) + bytes;
+            left -= bytes;
+            return ptr;
+        }
+
+        void do_deallocate (void*, std::size_t, std::size_t) noexcept override {}
+
+        bool do_is_equal (std::pmr::memory_resource const& rhs) const noexcept override {
+            return this == &rhs;
+        }
+
+    private:
+        void add_block (std::size_t needed) {
+            auto size = nextBlock;
+            while (size < needed + sizeof(Block)) {
+                size *= 2;
+            }
+
+            auto block = static_cast<Block*> (upstream->allocate (size, alignof(std::max_align_t)));
+            block->prev = last;
+            block->size = size;
+            last = block;
+
+            cur = reinterpret_cast<char*> (block + 1);
+            left = size - sizeof(Block);
+
+            if (nextBlock < maxBlock) {
+                nextBlock *= 2;
+            }
+        }
+
+    private:
+        std::pmr::memory_resource* upstream;
+        char* initial = nullptr;
+        std::size_t initialSize = 0;
+
+        Block* last = nullptr;
+        char* cur = nullptr;
+        std::size_t left = 0;
+        std::size_t nextBlock = minBlock;
+    };
+
+
+    // пул блоков одного размера для узлов списков и хеш-множеств:
+    // освобождённые блоки идут в список свободных и выдаются снова за O(1).
+    // Запросы больше блока или с большим выравниванием уходят в upstream.
+    // Память пула возвращается upstream только в release() и деструкторе.
+    // Не потокобезопасен
+    class PoolResource : public std::pmr::memory_resource {
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct Chunk {
+            Chunk* prev;
+            std::size_t size;
+        };
+
+        static constexpr std::size_t blocksPerChunk = 256;
+
+    public:
+        PoolResource (
+            std::size_t blockSize_
+          , std::size_t blockAlign_ = alignof(std::max_align_t)
+          , std::pmr::memory_resource* upstream_ = std::pmr::get_default_resource()
+        ) noexcept
+            : upstream (upstream_)
+            , blockSize (round_block (blockSize_, blockAlign_))
+            , blockAlign (blockAlign_ < alignof(FreeBlock) ? alignof(FreeBlock) : blockAlign_)
+        {}
+
+        PoolResource (PoolResource const&) = delete;
+        PoolResource& operator= (PoolResource const&) = delete;
+
+        ~PoolResource() override {
+            release();
+        }
+
+        void release() noexcept {
+            while (chunks) {
+                auto prev = chunks->prev;
+                upstream->deallocate (chunks, chunks->size, chunk_align());
+                chunks = prev;
+            }
+            freeList = nullptr;
+        }
+
+        std::size_t block_size() const noexcept {
+            return blockSize;
+        }
+
+    protected:
+        void* do_allocate (std::size_t bytes, std::size_t align) override {
+            if (not fits (bytes, align))
+                return upstream->allocate (bytes, align);
+
+            if (freeList == nullptr) {
+                add_chunk();
+            }
+
+            auto res = freeList;
+            freeList = res->next;
+            return res;
+        }
+
+        void do_deallocate (void* ptr, std::size_t bytes, std::size_t align) noexcept override {
+            if (not fits (bytes, align)) {
+                upstream->deallocate (ptr, bytes, align);
+                return;
+            }
+
+            auto block = static_cast<FreeBlock*> (ptr);
+            block->next = freeList;
+            freeList = block;
+        }
+
+        bool do_is_equal (std::pmr::memory_resource const& rhs) const noexcept override {
+            return this == &rhs;
+        }
+
+    private:
+        static
+        std::size_t round_block (std::size_t size, std::size_t align) noexcept {
+            if (size < sizeof(FreeBlock)) {
+                size = sizeof(FreeBlock);
+            }
+            if (align < alignof(FreeBlock)) {
+                align = alignof(FreeBlock);
+            }
+            return (size + align - 1) / align * align;
+        }
+
+        bool fits (std::size_t bytes, std::size_t align) const noexcept {
+            return bytes <= blockSize and align <= blockAlign;
+        }
+
+        std::size_t chunk_align() const noexcept {
+            return blockAlign < alignof(Chunk) ? alignof(Chunk) : blockAlign;
+        }
+
+        // заголовок занимает целое число блоков, чтобы блоки остались выровнены
+        void add_chunk() {
+            auto header = round_block (sizeof(Chunk), blockAlign);
+            header = (header + blockSize - 1) / blockSize * blockSize;
+            auto size = header + blockSize * blocksPerChunk;
+
+            auto chunk = static_cast<Chunk*> (upstream->allocate (size, chunk_align()));
+            chunk->prev = chunks;
+            chunk->size = size;
+            chunks = chunk;
+
+            auto first = reinterpret_cast<char*> (chunk) + header;
+            for (std::size_t i = blocksPerChunk; i-- > 0; ) {
+                auto block = reinterpret_cast<FreeBlock*> (first + i * blockSize);
+                block->next = freeList;
+                freeList = block;
+            }
+        }
+
+    private:
+        std::pmr::memory_resource* upstream;
+        std::size_t blockSize;
+        std::size_t blockAlign;
+
+        Chunk* chunks = nullptr;
+        FreeBlock* freeList = nullptr;
+    };
+}
+
+#endif
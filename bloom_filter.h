@@ -0,0 +1,186 @@
+#ifndef MY_BLOOM_FILTER_H_GUARD
+#define MY_BLOOM_FILTER_H_GUARD
+
+#include <cstdint>
+#include "dynamic_array.h"
+#include "hash_general.h"
+#include "hasher.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+namespace bloom_detail
+{
+    // блок - 256 бит, по одному биту на каждое из 8 слов. Блок выровнен
+    // по 32 байтам (std::allocator с C++17 учитывает выравнивание) и не
+    // пересекает границу линии кеша: любая проверка читает ровно одну линию
+    struct alignas(32) Block {
+        std::uint32_t words[8];
+    };
+
+
+    // нечётные множители, номер бита в слове i - старшие 5 бит (h * salt[i])
+    alignas(32) constexpr std::uint32_t salt[8] = {
+        0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du
+      , 0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+    };
+
+
+#if defined(__AVX2__)
+    inline __m256i make_mask (std::uint32_t h) noexcept {
+        auto salts = _mm256_load_si256 (reinterpret_cast<__m256i const*> (salt));
+        auto bits = _mm256_srli_epi32 (_mm256_mullo_epi32 (_mm256_set1_epi32 (h), salts), 27);
+        return _mm256_sllv_epi32 (_mm256_set1_epi32 (1), bits);
+    }
+
+
+    inline void set_bits (Block& block, std::uint32_t h) noexcept {
+        auto ptr = reinterpret_cast<__m256i*> (block.words);
+        _mm256_store_si256 (ptr, _mm256_or_si256 (_mm256_load_si256 (ptr), make_mask (h)));
+    }
+
+
+    inline bool test_bits (Block const& block, std::uint32_t h) noexcept {
+        auto ptr = reinterpret_cast<__m256i const*> (block.words);
+        return _mm256_testc_si256 (_mm256_load_si256 (ptr), make_mask (h));
+    }
+#else
+    inline void set_bits (Block& block, std::uint32_t h) noexcept {
+        for (int i = 0; i < 8; ++i) {
+            block.words[i] |= std::uint32_t (1) << ((h * salt[i]) >> 27);
+        }
+    }
+
+
+    inline bool test_bits (Block const& block, std::uint32_t h) noexcept {
+        for (int i = 0; i < 8; ++i) {
+            if (not (block.words[i] & (std::uint32_t (1) << ((h * salt[i]) >> 27))))
+                return false;
+        }
+        return true;
+    }
+#endif
+}
+
+
+namespace data_struct
+{
+    // блочный фильтр Блума над готовыми хешами (split block bloom filter).
+    // Удаления нет: после erase биты остаются до следующего reset,
+    // это даёт лишние ложные срабатывания, но не ложные отказы.
+    // Пока reset не вызывался, фильтр пропускает всё
+    class BlockedBloomFilter {
+        using Block = bloom_detail::Block;
+
+    public:
+        // около 1% ложных срабатываний
+        static constexpr std::size_t bitsPerKey = 12;
+
+    public:
+        BlockedBloomFilter() noexcept = default;
+
+        explicit BlockedBloomFilter (std::size_t expectedCount) {
+            reset (expectedCount);
+        }
+
+        // очищает фильтр и подбирает размер под expectedCount ключей
+        void reset (std::size_t expectedCount) {
+            auto blocksCnt = (expectedCount * bitsPerKey + 255) / 256;
+            blocks = DynamicArray<Block>{};
+            blocks.resize (blocksCnt == 0 ? 1 : blocksCnt);
+        }
+
+        void clear() noexcept {
+            for (std::size_t i = 0; i < blocks.size(); ++i) {
+                blocks[i] = Block{};
+            }
+        }
+
+        void add (std::size_t hash) noexcept {
+            if (blocks.empty())
+                return;
+
+            auto h = remix (hash);
+            bloom_detail::set_bits (blocks[block_index (h)], std::uint32_t (h));
+        }
+
+        bool may_contain (std::size_t hash) const noexcept {
+            if (blocks.empty())
+                return true;
+
+            auto h = remix (hash);
+            return bloom_detail::test_bits (blocks[block_index (h)], std::uint32_t (h));
+        }
+
+        std::size_t memory_usage() const noexcept {
+            return blocks.capacity() * sizeof(Block);
+        }
+
+        void swap (BlockedBloomFilter& rhs) noexcept {
+            blocks.swap (rhs.blocks);
+        }
+
+    private:
+        // младшие биты хеша уже выбрали корзину таблицы - перемешиваем заново
+        static
+        std::uint64_t remix (std::size_t hash) noexcept {
+            return hash_detail::hash_int (hash, 0);
+        }
+
+        // старшие 32 бита -> [0, blocks.size()) без деления
+        std::size_t block_index (std::uint64_t h) const noexcept {
+            return std::size_t (((h >> 32) * blocks.size()) >> 32);
+        }
+
+    private:
+        DynamicArray<Block> blocks{};
+    };
+
+
+    inline void swap (BlockedBloomFilter& lhs, BlockedBloomFilter& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+
+
+    // самостоятельный фильтр для значений: хеш берётся из Hasher
+    template <typename T, typename Hash = Hasher<T>>
+    class BloomFilter {
+    public:
+        explicit BloomFilter (std::size_t expectedCount, Hash const& hash = Hash{})
+            : hasher (hash)
+            , filter (expectedCount)
+        {}
+
+        template <typename K = T>
+        void add (K const& key) noexcept {
+            filter.add (hasher (key));
+        }
+
+        // false - ключа точно нет
+        template <typename K = T>
+        bool may_contain (K const& key) const noexcept {
+            return filter.may_contain (hasher (key));
+        }
+
+        void clear() noexcept {
+            filter.clear();
+        }
+
+        std::size_t memory_usage() const noexcept {
+            return filter.memory_usage();
+        }
+
+    private:
+        Hash hasher{};
+        BlockedBloomFilter filter;
+    };
+
+
+    // HashSet с фильтром перед обходом корзины: промахи почти не трогают списки
+    struct BloomHashPolicy : DefaultHashPolicy {
+        using Filter = BlockedBloomFilter;
+    };
+}
+
+#endif
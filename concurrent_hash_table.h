@@ -0,0 +1,210 @@
+#ifndef MY_CONCURRENT_HASH_TABLE_H_GUARD
+#define MY_CONCURRENT_HASH_TABLE_H_GUARD
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include "hash_table.h"
+#include "hasher.h"
+
+namespace data_struct
+{
+    // таблица из независимых шардов, у каждого свой HashTable и свой
+    // shared_mutex: читатели одного шарда не мешают друг другу, а писатели
+    // разных шардов не мешают никому. Шард выбирается по заново
+    // перемешанному хешу, а корзину в шарде таблица выбирает по исходному -
+    // так шард не отнимает у корзин биты ни при ModuloIndex, ни при FibonacciIndex.
+    // Итераторы наружу не отдаются - они жили бы дольше блокировки
+    template <
+        typename Key
+      , typename Value
+      , typename Hash = KeyValueHash<Key, Value>
+      , typename Eq = KeyValueEqual<Key, Value>
+      , typename Policy = DefaultHashPolicy
+    >
+    class ConcurrentHashTable {
+        using Table = HashTable<Key, Value, Hash, Eq, Policy>;
+        using ReadLock = std::shared_lock<std::shared_mutex>;
+        using WriteLock = std::unique_lock<std::shared_mutex>;
+
+        // на отдельной линии кеша, чтобы блокировки соседей не делили её
+        struct alignas(64) Shard {
+            mutable std::shared_mutex mutex;
+            Table table;
+        };
+
+    public:
+        static constexpr std::size_t defaultShardsCnt = 64;
+
+    public:
+        explicit ConcurrentHashTable (
+            std::size_t shardsCnt = defaultShardsCnt
+          , Hash const& hash = Hash{}
+          , Eq const& eq = Eq{}
+        )
+            : hasher (hash)
+            , shardsCnt_ (FibonacciIndex::fit (shardsCnt))
+            , shards (new Shard[shardsCnt_])
+        {
+            index.reset (shardsCnt_);
+
+            for (std::size_t i = 0; i < shardsCnt_; ++i) {
+                shards[i].table = Table {hash, eq};
+            }
+        }
+
+        ConcurrentHashTable (ConcurrentHashTable const&) = delete;
+        ConcurrentHashTable& operator= (ConcurrentHashTable const&) = delete;
+
+    public:
+        std::size_t shards_count() const noexcept {
+            return shardsCnt_;
+        }
+
+        // сумма по шардам, при параллельных вставках - лишь оценка
+        std::size_t size() const {
+            std::size_t res = 0;
+            for_each_shard ([&] (Table const& table) {
+                res += table.size();
+            });
+            return res;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // ключей станет примерно count, поровну на шард
+        void reserve (std::size_t count) {
+            for_each_shard ([&] (Table& table) {
+                table.reserve (count / shardsCnt_ + 1);
+            });
+        }
+
+        template <typename K = Key>
+        std::optional<Value> find (K const& key) const {
+            auto& shard = shard_for (key);
+            ReadLock lock {shard.mutex};
+
+            if (auto it = shard.table.find (key); it != shard.table.end())
+                return it->second;
+
+            return std::nullopt;
+        }
+
+        template <typename K = Key>
+        bool contains (K const& key) const {
+            auto& shard = shard_for (key);
+            ReadLock lock {shard.mutex};
+
+            return shard.table.find (key) != shard.table.end();
+        }
+
+        // вызывает f (value const&) под блокировкой чтения, без копирования
+        template <typename K, typename F>
+        bool visit (K const& key, F f) const {
+            Shard const& shard = shard_for (key);
+            ReadLock lock {shard.mutex};
+
+            Table const& table = shard.table;
+            auto it = table.find (key);
+            if (it == table.end())
+                return false;
+
+            f (it->second);
+            return true;
+        }
+
+        // true, если ключа не было и пара добавлена
+        template <typename... Ts>
+        bool add (Key const& key, Ts&&... params) {
+            auto& shard = shard_for (key);
+            WriteLock lock {shard.mutex};
+
+            return shard.table.try_emplace (key, std::forward<Ts> (params)...).second;
+        }
+
+        template <typename... Ts>
+        bool add (Key&& key, Ts&&... params) {
+            auto& shard = shard_for (key);
+            WriteLock lock {shard.mutex};
+
+            return shard.table.try_emplace (std::move (key), std::forward<Ts> (params)...).second;
+        }
+
+        // f (Value&) получает существующее значение или только что созданное Value{};
+        // чтение и изменение идут под одной блокировкой. true, если ключ добавлен
+        template <typename F>
+        bool upsert (Key const& key, F f) {
+            auto& shard = shard_for (key);
+            WriteLock lock {shard.mutex};
+
+            auto [it, added] = shard.table.try_emplace (key);
+            f (it->second);
+            return added;
+        }
+
+        template <typename V>
+        bool insert_or_assign (Key const& key, V&& value) {
+            auto& shard = shard_for (key);
+            WriteLock lock {shard.mutex};
+
+            return shard.table.insert_or_assign (key, std::forward<V> (value)).second;
+        }
+
+        // true, если ключ был и удалён
+        template <typename K = Key>
+        bool erase (K const& key) {
+            auto& shard = shard_for (key);
+            WriteLock lock {shard.mutex};
+
+            auto oldSize = shard.table.size();
+            shard.table.erase (key);
+            return shard.table.size() != oldSize;
+        }
+
+        // f (Table&) для каждого шарда по очереди, под блокировкой записи
+        template <typename F>
+        void for_each_shard (F f) {
+            for (std::size_t i = 0; i < shardsCnt_; ++i) {
+                WriteLock lock {shards[i].mutex};
+                f (shards[i].table);
+            }
+        }
+
+        // f (Table const&) для каждого шарда по очереди, под блокировкой чтения
+        template <typename F>
+        void for_each_shard (F f) const {
+            for (std::size_t i = 0; i < shardsCnt_; ++i) {
+                ReadLock lock {shards[i].mutex};
+                f (static_cast<Table const&> (shards[i].table));
+            }
+        }
+
+    private:
+        // под блокировкой чтения таблица доступна только как const
+        template <typename K>
+        Shard const& shard_for (K const& key) const noexcept {
+            return shards[index (remix (hasher (key)))];
+        }
+
+        template <typename K>
+        Shard& shard_for (K const& key) noexcept {
+            return shards[index (remix (hasher (key)))];
+        }
+
+        static
+        std::size_t remix (std::size_t hash) noexcept {
+            return std::size_t (hash_detail::hash_int (hash, 0));
+        }
+
+    private:
+        Hash hasher{};
+        FibonacciIndex index{};
+        std::size_t shardsCnt_ = 0;
+        std::unique_ptr<Shard[]> shards;
+    };
+}
+
+#endif
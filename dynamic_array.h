@@ -1,8 +1,12 @@
 #ifndef DYNAMIC_ARRAY_GUARD_H
 #define DYNAMIC_ARRAY_GUARD_H
 
+#include <cstring>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
+#include "allocator.h"
 #include "iterators.h"
 #include "my_algorithm.h"
 
@@ -63,73 +67,128 @@ namespace array_detail
     public:
         mutable T* ptr{};
     };
+
+
+    // распределитель умеет менять размер буфера на месте:
+    // T* reallocate (T* ptr, std::size_t oldCount, std::size_t newCount)
+    template <typename Alloc, typename T, typename = void>
+    struct HasReallocate : std::false_type {};
+
+
+    template <typename Alloc, typename T>
+    struct HasReallocate<Alloc, T, std::void_t<decltype (
+        std::declval<Alloc&>().reallocate (std::declval<T*>(), std::size_t{}, std::size_t{})
+    )>> : std::true_type {};
 }
 
 namespace data_struct
 {
-    template <typename T>
-    class DynamicArray {
+    // перенос объекта в другое место памяти сводится к копированию байтов,
+    // а старый объект можно просто забыть. Для своих типов без указателей
+    // на самих себя: template <> struct IsTriviallyRelocatable<MyType> : std::true_type {};
+    template <typename T, typename = void>
+    struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+
+    // Alloc хранится как пустая база, если у него нет состояния.
+    // Если Alloc умеет reallocate, а T переносим побайтно, рост и
+    // shrink_to_fit идут через него без копирования элементов (MmapAllocator)
+    template <typename T, typename Alloc = std::allocator<T>>
+    class DynamicArray : private Alloc {
         using IterImpl = array_detail::IterImpl<T, DynamicArray>;
+        using AllocTraits = std::allocator_traits<Alloc>;
+
+        static constexpr bool reallocInPlace = IsTriviallyRelocatable<T>::value
+                                           and array_detail::HasReallocate<Alloc, T>::value;
 
     public:
         using iterator       = RandomIterator<T, IterImpl, Mutable_tag>;
         using const_iterator = RandomIterator<T, IterImpl, Const_tag>;
+        using allocator_type = Alloc;
 
     public:
-        DynamicArray() noexcept = default;
+        DynamicArray() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+
+        explicit DynamicArray (Alloc const& alloc) noexcept
+            : Alloc (alloc)
+        {}
 
         DynamicArray (DynamicArray&& rhs) noexcept
-            : capacity_ (std::exchange (rhs.capacity_, 0))
+            : Alloc (std::move (rhs.alloc()))
+            , capacity_ (std::exchange (rhs.capacity_, 0))
             , begin_ (std::exchange (rhs.begin_, nullptr))
             , end_ (std::exchange (rhs.end_, nullptr))
         {}
 
         template <class Iter, class = EnableIfForward<Iter>>
-        DynamicArray (Iter beg, Iter end)
-            : DynamicArray ()
+        DynamicArray (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : DynamicArray (alloc)
         {
-            algs::copy (beg, end, algs::back_inserter (*this));
+            for (; beg != end; ++beg) {
+                emplace_back (*beg);
+            }
         }
 
-        DynamicArray (std::initializer_list<T> iList)
-            : DynamicArray (iList.size(), InitTag{})
+        DynamicArray (std::initializer_list<T> iList, Alloc const& alloc = Alloc{})
+            : DynamicArray (iList.size(), InitTag{}, alloc)
         {
-            algs::copy (iList.begin(), iList.end(), algs::back_inserter (*this));
+            copy_init (iList.begin(), iList.size());
         }
 
         DynamicArray (DynamicArray const& rhs)
-            : DynamicArray (rhs.size(), InitTag{})
+            : DynamicArray (rhs, alloc_detail::select_for_copy (rhs.alloc()))
+        {}
+
+        DynamicArray (DynamicArray const& rhs, Alloc const& alloc)
+            : DynamicArray (rhs.size(), InitTag{}, alloc)
         {
-            algs::copy (rhs.begin(), rhs.end(), algs::back_inserter (*this));
+            copy_init (rhs.begin_, rhs.size());
         }
 
-        DynamicArray (std::size_t count, T const& value = T())
-            : DynamicArray (count, InitTag{})
+        DynamicArray (std::size_t count, T const& value = T(), Alloc const& alloc = Alloc{})
+            : DynamicArray (count, InitTag{}, alloc)
         {
             while (count--) {
-                push_back (value);
+                new (end_) T {value};
+                ++end_;
             }
         }
 
-        DynamicArray& operator= (DynamicArray&& rhs) noexcept {
-            if (this != &rhs) {
+        // буфер забирается, только если его можно вернуть через свой
+        // распределитель, иначе элементы переносятся по одному
+        DynamicArray& operator= (DynamicArray&& rhs) noexcept (AllocTraits::is_always_equal::value) {
+            if (this == &rhs)
+                return *this;
+
+            if (alloc_detail::can_take_storage (alloc(), rhs.alloc())) {
                 auto tmp {std::move (rhs)};
                 swap (tmp);
+            } else {
+                DynamicArray tmp (alloc());
+                tmp.reserve (rhs.size());
+                for (auto& el : rhs) {
+                    tmp.emplace_back (std::move (el));
+                }
+                swap (tmp);
             }
             return *this;
         }
 
         DynamicArray& operator= (DynamicArray const& rhs) {
             if (this != &rhs) {
-                auto tmp {rhs};
+                DynamicArray tmp {rhs, alloc_detail::for_copy_assign (alloc(), rhs.alloc())};
                 swap (tmp);
             }
             return *this;
         }
 
         ~DynamicArray() noexcept {
-            resize(0);
-            mem_free (begin_);
+            destroy (begin_, end_);
+            mem_free (begin_, capacity_);
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return alloc();
         }
 
         auto begin() noexcept {
@@ -181,6 +240,7 @@ namespace data_struct
         }
 
         void swap (DynamicArray& rhs) noexcept {
+            alloc_detail::swap (alloc(), rhs.alloc());
             std::swap (capacity_, rhs.capacity_);
             std::swap (begin_, rhs.begin_);
             std::swap (end_, rhs.end_);
@@ -200,7 +260,11 @@ namespace data_struct
 
         template <typename... Ts>
         void emplace_back (Ts&&... args) {
-            reserve_before_insert();
+            if (end_ == begin_ + capacity_) {
+                realloc_emplace_back (std::forward<Ts> (args)...);
+                return;
+            }
+
             new(end_) T {std::forward<Ts> (args)...};
             ++end_;
         }
@@ -248,54 +312,168 @@ namespace data_struct
             realloc_if_capacity_less (newCapacity, newCapacity);
         }
 
+        // лишняя ёмкость возвращается распределителю
+        void shrink_to_fit() {
+            if (capacity() != size()) {
+                realloc_storage (size());
+            }
+        }
+
         void resize (std::size_t newSize) {
             reserve (newSize);
-        
+
+            if (newSize < size()) {
+                destroy (begin_ + newSize, end_);
+                end_ = begin_ + newSize;
+            }
+
             while (size() != newSize) {
-                size() < newSize ? push_back (T{}) : pop_back();
+                new (end_) T{};
+                ++end_;
             }
-        }   
+        }
 
     private:
         struct InitTag{};
-        struct MoveInitTag{};
         
-        DynamicArray (std::size_t memSize, InitTag _)
-            : capacity_ (memSize)
+        DynamicArray (std::size_t memSize, InitTag, Alloc const& alloc = Alloc{})
+            : Alloc (alloc)
+            , capacity_ (memSize)
             , begin_ (mem_alloc (memSize))
             , end_ (begin_)
         {}
 
-        DynamicArray (iterator beg, iterator end, std::size_t memSize, MoveInitTag _)
-            : DynamicArray (memSize, InitTag{})
-        {
-            algs::move (beg, end, algs::back_inserter (*this));
+        Alloc& alloc() noexcept {
+            return *this;
+        }
+
+        Alloc const& alloc() const noexcept {
+            return *this;
         }
 
         T* mem_alloc (std::size_t count) {
             if (count == 0)
                 return nullptr;
 
-            return reinterpret_cast<T*> (
-                ::operator new (sizeof(T) * count)
-            );
+            return AllocTraits::allocate (alloc(), count);
         }
 
-        void mem_free (T* ptr) noexcept {
-            ::operator delete(ptr);
+        void mem_free (T* ptr, std::size_t count) noexcept {
+            if (ptr) {
+                AllocTraits::deallocate (alloc(), ptr, count);
+            }
         }
 
-        void realloc_if_capacity_less (std::size_t lowerBound, std::size_t newCapacity) {
-            if (capacity() >= lowerBound)
-                return;
+        // память свежая, end_ растёт по мере построения: при исключении
+        // деструктор разрушит ровно построенное
+        void copy_init (T const* src, std::size_t count) {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                if (count != 0) {
+                    std::memcpy (static_cast<void*> (begin_), static_cast<void const*> (src), count * sizeof(T));
+                }
+                end_ = begin_ + count;
+            } else {
+                for (std::size_t i = 0; i < count; ++i) {
+                    new (end_) T {src[i]};
+                    ++end_;
+                }
+            }
+        }
+
+        static
+        void destroy (T* beg, T* end) noexcept {
+            if constexpr (not std::is_trivially_destructible_v<T>) {
+                for (; beg != end; ++beg) {
+                    beg->~T();
+                }
+            }
+        }
+
+        // элементы переезжают в newBegin, старый буфер освобождается.
+        // Если перемещение может бросить, а копирование есть, элементы
+        // копируются: при исключении всё остаётся на старом месте,
+        // newBegin освобождает вызывающий. Некопируемые типы с бросающим
+        // перемещением при исключении оставляют часть элементов перемещёнными
+        void relocate_to (T* newBegin, std::size_t newCapacity) {
+            auto count = size();
+
+            if constexpr (IsTriviallyRelocatable<T>::value) {
+                if (count != 0) {
+                    std::memcpy (static_cast<void*> (newBegin), static_cast<void const*> (begin_), count * sizeof(T));
+                }
+            } else {
+                std::size_t moved = 0;
+                try {
+                    for (; moved < count; ++moved) {
+                        new (newBegin + moved) T {std::move_if_noexcept (begin_[moved])};
+                    }
+                } catch (...) {
+                    destroy (newBegin, newBegin + moved);
+                    throw;
+                }
+                destroy (begin_, end_);
+            }
 
-            DynamicArray tmp (begin(), end(), newCapacity, MoveInitTag{});
-            swap (tmp);
+            mem_free (begin_, capacity_);
+            begin_ = newBegin;
+            end_ = newBegin + count;
+            capacity_ = newCapacity;
+        }
+
+        // newCapacity не меньше size()
+        void realloc_storage (std::size_t newCapacity) {
+            if constexpr (reallocInPlace) {
+                auto count = size();
+                begin_ = alloc().reallocate (begin_, capacity_, newCapacity);
+                end_ = begin_ + count;
+                capacity_ = newCapacity;
+            } else {
+                auto newBegin = mem_alloc (newCapacity);
+                try {
+                    relocate_to (newBegin, newCapacity);
+                } catch (...) {
+                    mem_free (newBegin, newCapacity);
+                    throw;
+                }
+            }
         }
 
-        void reserve_before_insert () {
-            auto memSize = empty() ? minCapacity : size() * 2;
-            realloc_if_capacity_less (size() + 1, memSize);
+        void realloc_if_capacity_less (std::size_t lowerBound, std::size_t newCapacity) {
+            if (capacity() < lowerBound) {
+                realloc_storage (newCapacity);
+            }
+        }
+
+        // новый элемент строится до переезда: args могут ссылаться
+        // на элементы самого массива (push_back (back()))
+        template <typename... Ts>
+        void realloc_emplace_back (Ts&&... args) {
+            auto count = size();
+            auto newCapacity = empty() ? minCapacity : count * 2;
+
+            if constexpr (reallocInPlace) {
+                T value {std::forward<Ts> (args)...};
+                realloc_storage (newCapacity);
+                new (end_) T {std::move (value)};
+            } else {
+                auto newBegin = mem_alloc (newCapacity);
+
+                try {
+                    new (newBegin + count) T {std::forward<Ts> (args)...};
+                } catch (...) {
+                    mem_free (newBegin, newCapacity);
+                    throw;
+                }
+
+                try {
+                    relocate_to (newBegin, newCapacity);
+                } catch (...) {
+                    newBegin[count].~T();
+                    mem_free (newBegin, newCapacity);
+                    throw;
+                }
+            }
+            ++end_;
         }
 
         static
@@ -314,11 +492,26 @@ namespace data_struct
     };
 
 
-    template <typename T>
-    void swap (DynamicArray<T>& lhs, DynamicArray<T>& rhs)
+    template <typename T, typename Alloc>
+    void swap (DynamicArray<T, Alloc>& lhs, DynamicArray<T, Alloc>& rhs)
     {
         lhs.swap(rhs);
     }
+
+
+    // буфер не ссылается сам на себя; пустой распределитель (std::allocator
+    // в libstdc++ не тривиально копируем) переносить нечего
+    template <typename T, typename Alloc>
+    struct IsTriviallyRelocatable<DynamicArray<T, Alloc>>
+        : std::bool_constant<std::is_empty_v<Alloc> or IsTriviallyRelocatable<Alloc>::value>
+    {};
+
+
+    namespace pmr
+    {
+        template <typename T>
+        using DynamicArray = data_struct::DynamicArray<T, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef MY_FIXED_STRING_H_GUARD
+#define MY_FIXED_STRING_H_GUARD
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include "hasher.h"
+
+namespace data_struct
+{
+    // строка не длиннее N байт прямо внутри объекта: тривиально копируется,
+    // поэтому годится для снимков в файле (MappedHashTable)
+    template <std::size_t N>
+    class FixedString {
+        using Size = std::conditional_t<(N < 256), std::uint8_t, std::uint32_t>;
+
+    public:
+        FixedString() noexcept = default;
+
+        FixedString (std::string_view str) {
+            if (str.size() > N) throw std::runtime_error (
+                "строка не помещается в FixedString\n"
+            );
+
+            std::memcpy (data_, str.data(), str.size());
+            size_ = Size (str.size());
+        }
+
+        FixedString (char const* str)
+            : FixedString (std::string_view {str})
+        {}
+
+        std::string_view view() const noexcept {
+            return {data_, size_};
+        }
+
+        operator std::string_view() const noexcept {
+            return view();
+        }
+
+        char const* data() const noexcept {
+            return data_;
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        bool empty() const noexcept {
+            return size_ == 0;
+        }
+
+        friend bool operator== (FixedString const& lhs, FixedString const& rhs) noexcept {
+            return lhs.view() == rhs.view();
+        }
+
+        friend bool operator== (std::string_view lhs, FixedString const& rhs) noexcept {
+            return lhs == rhs.view();
+        }
+
+        friend bool operator== (FixedString const& lhs, std::string_view rhs) noexcept {
+            return lhs.view() == rhs;
+        }
+
+        friend bool operator!= (FixedString const& lhs, FixedString const& rhs) noexcept {
+            return not (lhs == rhs);
+        }
+
+    private:
+        // хвост обнулён: одинаковые строки дают одинаковые байты в снимке
+        char data_[N] = {};
+        Size size_ = 0;
+    };
+
+
+    // хеш совпадает с хешем std::string_view, поиск по string_view без копий
+    template <std::size_t N>
+    struct Hasher<FixedString<N>> : Hasher<std::string_view> {
+        using Hasher<std::string_view>::Hasher;
+    };
+}
+
+#endif
@@ -0,0 +1,869 @@
+#ifndef MY_FLAT_HASH_SET_H_GUARD
+#define MY_FLAT_HASH_SET_H_GUARD
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "allocator.h"
+#include "iterators.h"
+#include "my_algorithm.h"
+#include "hash_general.h"
+#include "hasher.h"
+#include "hash_stats.h"
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+    #include <immintrin.h>
+#endif
+
+
+namespace flat_detail
+{
+    using ctrl_t = std::int8_t;
+    using mask_t = std::uint32_t;
+
+    // свободные и удалённые ячейки отрицательны, занятые хранят 7 бит хеша
+    constexpr ctrl_t Empty   = -128;
+    constexpr ctrl_t Deleted = -2;
+
+
+    inline bool is_full (ctrl_t c) noexcept {
+        return c >= 0;
+    }
+
+
+    inline unsigned lowest_bit (mask_t mask) noexcept {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long ind;
+        _BitScanForward (&ind, mask);
+        return ind;
+    #else
+        return __builtin_ctz (mask);
+    #endif
+    }
+
+
+    // начальная группа - по перемешанному хешу, 7 младших бит - в управляющий байт
+    inline std::size_t h1 (std::size_t hash) noexcept {
+        auto mixed = std::uint64_t (hash) * 0x9E3779B97F4A7C15ull;
+        return std::size_t (mixed ^ (mixed >> 32));
+    }
+
+
+    inline ctrl_t h2 (std::size_t hash) noexcept {
+        return ctrl_t (hash & 0x7F);
+    }
+
+
+#if defined(__AVX2__)
+    struct Group {
+        static constexpr std::size_t width = 32;
+
+        explicit Group (ctrl_t const* pos) noexcept
+            : ctrl (_mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pos)))
+        {}
+
+        mask_t match (ctrl_t h2) const noexcept {
+            auto eq = _mm256_cmpeq_epi8 (ctrl, _mm256_set1_epi8 (h2));
+            return _mm256_movemask_epi8 (eq);
+        }
+
+        mask_t match_empty() const noexcept {
+            return match (Empty);
+        }
+
+        mask_t match_free() const noexcept {
+            return _mm256_movemask_epi8 (ctrl);
+        }
+
+        __m256i ctrl;
+    };
+#elif defined(__SSE2__) || defined(_M_X64)
+    struct Group {
+        static constexpr std::size_t width = 16;
+
+        explicit Group (ctrl_t const* pos) noexcept
+            : ctrl (_mm_loadu_si128 (reinterpret_cast<__m128i const*> (pos)))
+        {}
+
+        mask_t match (ctrl_t h2) const noexcept {
+            auto eq = _mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 (h2));
+            return _mm_movemask_epi8 (eq);
+        }
+
+        mask_t match_empty() const noexcept {
+            return match (Empty);
+        }
+
+        mask_t match_free() const noexcept {
+            return _mm_movemask_epi8 (ctrl);
+        }
+
+        __m128i ctrl;
+    };
+#else
+    struct Group {
+        static constexpr std::size_t width = 16;
+
+        explicit Group (ctrl_t const* pos) noexcept
+            : ctrl (pos)
+        {}
+
+        mask_t match (ctrl_t h2) const noexcept {
+            mask_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= mask_t (ctrl[i] == h2) << i;
+            }
+            return mask;
+        }
+
+        mask_t match_empty() const noexcept {
+            return match (Empty);
+        }
+
+        mask_t match_free() const noexcept {
+            mask_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= mask_t (not is_full (ctrl[i])) << i;
+            }
+            return mask;
+        }
+
+        ctrl_t const* ctrl;
+    };
+#endif
+
+
+    template <typename T, typename C>
+    struct IterImpl {
+        using Container = C;
+
+    public:
+        auto real() const noexcept {
+            return ctrl;
+        }
+
+        bool equal (IterImpl const& rhs) const noexcept {
+            return ctrl == rhs.ctrl;
+        }
+
+        void next() noexcept {
+            ++ctrl;
+            ++slot;
+            skip_free();
+        }
+
+        T& get_value() const noexcept {
+            return *slot;
+        }
+
+        void skip_free() noexcept {
+            while (ctrl != ctrlEnd and not is_full (*ctrl)) {
+                ++ctrl;
+                ++slot;
+            }
+        }
+
+    public:
+        ctrl_t* ctrl = nullptr;
+        ctrl_t* ctrlEnd = nullptr;
+        T* slot = nullptr;
+    };
+}
+
+
+namespace data_struct
+{
+    template <
+        typename T
+      , typename Hash = Hasher<T>
+      , typename Eq = DefaultEqual<T>
+      , typename Policy = FlatHashPolicy
+      , typename Alloc = std::allocator<T>
+    >
+    class FlatHashSet : private Alloc {
+        using ctrl_t = flat_detail::ctrl_t;
+        using mask_t = flat_detail::mask_t;
+        using Group  = flat_detail::Group;
+
+        using AllocTraits = std::allocator_traits<Alloc>;
+        using CtrlAlloc = alloc_detail::Rebind<Alloc, ctrl_t>;
+
+        using IterImpl = flat_detail::IterImpl<T, FlatHashSet>;
+        using BackIns = BackInserterIterator<T, FlatHashSet>;
+
+        friend IterImpl;
+        friend BackIns;
+
+        // управляющие байты уже служат и фильтром, и кешем части хеша
+        static_assert (std::is_same_v<typename Policy::Filter, NoFilter>, "FlatHashSet не поддерживает Policy::Filter");
+        static_assert (not Policy::incrementalRehash, "FlatHashSet не поддерживает incrementalRehash");
+        static_assert (not Policy::cacheHash, "FlatHashSet не поддерживает cacheHash");
+
+
+        template <typename T1>
+        using EnableIfIsT = std::enable_if_t<
+            std::is_same_v<std::remove_reference<T1>, T>
+         or std::is_constructible_v<T, T1>
+        >;
+
+        template <typename K>
+        using EnableIfTransparent = std::enable_if_t<
+            hash_detail::IsTransparent<Hash, K>::value
+        and hash_detail::IsTransparent<Eq, K>::value
+        >;
+
+    public:
+        using iterator       = ForwardIterator<T, IterImpl, Mutable_tag>;
+        using const_iterator = ForwardIterator<T, IterImpl, Const_tag>;
+        using allocator_type = Alloc;
+
+    public:
+        FlatHashSet() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+
+        explicit FlatHashSet (Alloc const& alloc)
+            : Alloc (alloc)
+        {}
+
+        explicit FlatHashSet (Hash const& hash, Eq const& eq = Eq{}, Alloc const& alloc = Alloc{})
+            : Alloc (alloc)
+            , hasher (hash)
+            , keyEq (eq)
+        {}
+
+        FlatHashSet (FlatHashSet&& rhs) noexcept
+            : Alloc (std::move (rhs.alloc()))
+            , hasher (rhs.hasher)
+            , keyEq (rhs.keyEq)
+            , maxLoad (rhs.maxLoad)
+            , rehashLog (rhs.rehashLog)
+            , counters (rhs.counters)
+            , ctrl (std::exchange (rhs.ctrl, nullptr))
+            , slots (std::exchange (rhs.slots, nullptr))
+            , capacity_ (std::exchange (rhs.capacity_, 0))
+            , size_ (std::exchange (rhs.size_, 0))
+            , growthLeft (std::exchange (rhs.growthLeft, 0))
+        {}
+
+        FlatHashSet (FlatHashSet const& rhs)
+            : FlatHashSet (rhs, alloc_detail::select_for_copy (rhs.alloc()))
+        {}
+
+        FlatHashSet (FlatHashSet const& rhs, Alloc const& alloc)
+            : Alloc (alloc)
+            , hasher (rhs.hasher)
+            , keyEq (rhs.keyEq)
+            , maxLoad (rhs.maxLoad)
+            , counters (rhs.counters)
+        {
+            if (rhs.empty())
+                return;
+
+            realloc_slots (rhs.capacity_);
+            algs::for_each (rhs.begin(), rhs.end(), [&] (auto& el) {
+                construct_unique (hasher (el), [&] {
+                    return el;
+                });
+            });
+            rehashLog = rhs.rehashLog;
+        }
+
+        template <class Iter, class = EnableIfForward<Iter>>
+        FlatHashSet (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : FlatHashSet (alloc)
+        {
+            insert (beg, end);
+        }
+
+        FlatHashSet (std::initializer_list<T> iList, Alloc const& alloc = Alloc{})
+            : FlatHashSet (alloc)
+        {
+            algs::copy (iList.begin(), iList.end(), BackIns (*this));
+        }
+
+        // ячейки забираются, только если их можно вернуть через свой
+        // распределитель, иначе элементы переносятся по одному
+        FlatHashSet& operator= (FlatHashSet&& rhs) noexcept (AllocTraits::is_always_equal::value) {
+            if (this == &rhs)
+                return *this;
+
+            if (alloc_detail::can_take_storage (alloc(), rhs.alloc())) {
+                auto tmp {std::move (rhs)};
+                swap (tmp);
+            } else {
+                FlatHashSet tmp {rhs.hasher, rhs.keyEq, alloc()};
+                tmp.maxLoad = rhs.maxLoad;
+                tmp.reserve (rhs.size());
+                for (auto& el : rhs) {
+                    tmp.add (std::move (el));
+                }
+                swap (tmp);
+            }
+            return *this;
+        }
+
+        FlatHashSet& operator= (FlatHashSet const& rhs) {
+            if (this != &rhs) {
+                FlatHashSet tmp {rhs, alloc_detail::for_copy_assign (alloc(), rhs.alloc())};
+                swap (tmp);
+            }
+            return *this;
+        }
+
+        ~FlatHashSet() noexcept {
+            destroy_slots();
+        }
+
+        void swap (FlatHashSet& rhs) noexcept {
+            alloc_detail::swap (alloc(), rhs.alloc());
+            std::swap (hasher, rhs.hasher);
+            std::swap (keyEq, rhs.keyEq);
+            std::swap (maxLoad, rhs.maxLoad);
+            std::swap (rehashLog, rhs.rehashLog);
+            std::swap (counters, rhs.counters);
+            std::swap (ctrl, rhs.ctrl);
+            std::swap (slots, rhs.slots);
+            std::swap (capacity_, rhs.capacity_);
+            std::swap (size_, rhs.size_);
+            std::swap (growthLeft, rhs.growthLeft);
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return alloc();
+        }
+
+        Hash const& hash_function() const noexcept {
+            return hasher;
+        }
+
+        Eq const& key_eq() const noexcept {
+            return keyEq;
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        iterator begin() noexcept {
+            return begin_iter_impl();
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin_iter_impl();
+        }
+
+        const_iterator begin() const noexcept {
+            return cbegin();
+        }
+
+        iterator end() noexcept {
+            return iter_impl (capacity_);
+        }
+
+        const_iterator cend() const noexcept {
+            return iter_impl (capacity_);
+        }
+
+        const_iterator end() const noexcept {
+            return cend();
+        }
+
+        void erase (T const& value) noexcept {
+            erase_ (value);
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        void erase (K const& key) noexcept {
+            erase_ (key);
+        }
+
+        template <class T1, class = EnableIfIsT<T1>>
+        Pair<iterator, bool> add (T1&& value) {
+            return lazy_emplace (value, [&] {
+                return T (std::forward<T1> (value));
+            });
+        }
+
+        template <typename... Ts>
+        Pair<iterator, bool> emplace (Ts&&... params) {
+            T value {std::forward<Ts> (params)...};
+
+            return lazy_emplace (value, [&] {
+                return std::move (value);
+            });
+        }
+
+        // место под весь диапазон выделяется заранее, рехеширований по ходу нет
+        template <class Iter, class = EnableIfForward<Iter>>
+        void insert (Iter beg, Iter end) {
+            std::size_t count = 0;
+            for (auto it = beg; it != end; ++it) {
+                ++count;
+            }
+
+            reserve (size() + count);
+            for (; beg != end; ++beg) {
+                add (*beg);
+            }
+        }
+
+        // цепочки проб пересекают любые границы, поэтому без разбиения
+        // на части: то же, что insert, параметр threads - для общего интерфейса
+        template <typename RandomIt>
+        void build (RandomIt beg, RandomIt end, std::size_t threads = 1) {
+            (void) threads;
+            insert (beg, end);
+        }
+
+        // если элемента, равного key, нет - строит make() прямо в ячейке
+        template <typename K, typename Make>
+        Pair<iterator, bool> lazy_emplace (K const& key, Make make) {
+            auto hash = hasher (key);
+
+            if (auto ind = find_index (hash, key); ind != capacity_)
+                return {iter_impl (ind), false};
+
+            return {iter_impl (construct_unique (hash, make)), true};
+        }
+
+        iterator find (T const& value) noexcept {
+            return iter_impl (find_index (hasher (value), value));
+        }
+
+        const_iterator find (T const& value) const noexcept {
+            return iter_impl (find_index (hasher (value), value));
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        iterator find (K const& key) noexcept {
+            return iter_impl (find_index (hasher (key), key));
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        const_iterator find (K const& key) const noexcept {
+            return iter_impl (find_index (hasher (key), key));
+        }
+
+        // результат поиска каждого ключа из [beg, end) пишется в out;
+        // ключи обрабатываются пачками: сначала все хеши и предвыборка
+        // первых групп, потом сам поиск
+        template <typename It, typename OutIt>
+        OutIt find_batch (It beg, It end, OutIt out) noexcept {
+            lookup_batch (beg, end, [&] (std::size_t ind) {
+                *out = iterator {iter_impl (ind)};
+                ++out;
+            });
+            return out;
+        }
+
+        template <typename It, typename OutIt>
+        OutIt find_batch (It beg, It end, OutIt out) const noexcept {
+            lookup_batch (beg, end, [&] (std::size_t ind) {
+                *out = const_iterator {iter_impl (ind)};
+                ++out;
+            });
+            return out;
+        }
+
+        template <typename It, typename OutIt>
+        OutIt contains_batch (It beg, It end, OutIt out) const noexcept {
+            lookup_batch (beg, end, [&] (std::size_t ind) {
+                *out = ind != capacity_;
+                ++out;
+            });
+            return out;
+        }
+
+        std::size_t bucket_count() const noexcept {
+            return capacity_;
+        }
+
+        float load_factor() const noexcept {
+            return empty() ? 0.f : float (size()) / capacity_;
+        }
+
+        float max_load_factor() const noexcept {
+            return maxLoad;
+        }
+
+        // выше 7/8 почти в каждой группе не остаётся пустых ячеек
+        // и поиск отсутствующих элементов проходит всю таблицу
+        void max_load_factor (float factor) {
+            hash_detail::check_max_load (factor);
+            maxLoad = factor < maxLoadLimit ? factor : maxLoadLimit;
+
+            if (capacity_ != 0) {
+                realloc_slots (capacity_for (size()));
+            }
+        }
+
+        // ячеек станет не меньше count и не меньше, чем нужно для size()
+        void rehash (std::size_t count) {
+            auto needed = capacity_for (size());
+            auto newCapacity = capacity_for (0);
+
+            while (newCapacity < count) {
+                newCapacity *= 2;
+            }
+            newCapacity = newCapacity < needed ? needed : newCapacity;
+
+            if (size() != 0 or count != 0) {
+                realloc_slots (newCapacity);
+            }
+        }
+
+        // вставка count элементов не вызовет рехеширования
+        void reserve (std::size_t count) {
+            if (count > max_filled (capacity_)) {
+                realloc_slots (capacity_for (count));
+            }
+        }
+
+        // число ячеек - по текущему размеру, пустое множество освобождает всё
+        void shrink_to_fit() {
+            if (empty()) {
+                release();
+                return;
+            }
+
+            auto newCapacity = capacity_for (size());
+            if (newCapacity < capacity_) {
+                realloc_slots (newCapacity);
+            }
+        }
+
+        // глубина - сколько групп пройдено от начальной до ячейки элемента
+        HashStats stats() const {
+            HashStats res;
+            res.size = size();
+            res.bucketCount = capacity_;
+            res.loadFactor = load_factor();
+
+            for (std::size_t i = 0; i < capacity_; ++i) {
+                if (flat_detail::is_full (ctrl[i])) {
+                    hash_detail::add_depth (res, probe_depth (hasher (slots[i]), i / Group::width));
+                }
+            }
+
+            rehashLog.fill (res);
+            counters.fill (res);
+
+            res.elementsBytes = capacity_ * sizeof(T);
+            res.tableBytes = capacity_ * sizeof(ctrl_t);
+            return res;
+        }
+
+    private:
+        std::size_t probe_depth (std::size_t hash, std::size_t targetGroup) const noexcept {
+            auto mask = groups_mask();
+            auto group = h1 (hash) & mask;
+            std::size_t depth = 0;
+
+            while (group != targetGroup) {
+                ++depth;
+                group = (group + depth) & mask;
+            }
+            return depth;
+        }
+
+        static
+        std::size_t h1 (std::size_t hash) noexcept {
+            return flat_detail::h1 (hash);
+        }
+
+        static
+        ctrl_t h2 (std::size_t hash) noexcept {
+            return flat_detail::h2 (hash);
+        }
+
+        std::size_t groups_mask() const noexcept {
+            return capacity_ / Group::width - 1;
+        }
+
+        IterImpl iter_impl (std::size_t ind) const noexcept {
+            return IterImpl {ctrl + ind, ctrl + capacity_, slots + ind};
+        }
+
+        IterImpl begin_iter_impl() const noexcept {
+            auto impl = iter_impl (0);
+            impl.skip_free();
+            return impl;
+        }
+
+        // группы перебираются квадратично: g, g+1, g+3, g+6...
+        // при степени двойки число групп обходится каждая группа
+        template <typename T1>
+        std::size_t find_index (std::size_t hash, T1 const& value) const noexcept {
+            auto ind = find_in_groups (hash, value);
+            counters.lookup (ind != capacity_);
+            return ind;
+        }
+
+        template <typename T1>
+        std::size_t find_in_groups (std::size_t hash, T1 const& value) const noexcept {
+            if (capacity_ == 0)
+                return capacity_;
+
+            auto mask = groups_mask();
+            auto group = h1 (hash) & mask;
+
+            for (std::size_t step = 1; ; ++step) {
+                auto first = group * Group::width;
+                Group g {ctrl + first};
+
+                for (auto m = g.match (h2 (hash)); m != 0; m &= m - 1) {
+                    auto ind = first + flat_detail::lowest_bit (m);
+                    counters.probe();
+                    if (keyEq (value, slots[ind]))
+                        return ind;
+                }
+
+                if (g.match_empty() != 0 or step > mask)
+                    return capacity_;
+
+                group = (group + step) & mask;
+            }
+        }
+
+        template <typename It, typename F>
+        void lookup_batch (It beg, It end, F onFound) const noexcept {
+            std::size_t hashes[hash_detail::lookupBatch];
+
+            while (beg != end) {
+                auto chunkBeg = beg;
+                std::size_t cnt = 0;
+
+                for (; cnt != hash_detail::lookupBatch and beg != end; ++beg, ++cnt) {
+                    hashes[cnt] = hasher (*beg);
+
+                    if (capacity_ != 0) {
+                        auto first = (h1 (hashes[cnt]) & groups_mask()) * Group::width;
+                        hash_detail::prefetch (ctrl + first);
+                        hash_detail::prefetch (slots + first);
+                    }
+                }
+
+                for (std::size_t i = 0; i != cnt; ++i, ++chunkBeg) {
+                    onFound (find_index (hashes[i], *chunkBeg));
+                }
+            }
+        }
+
+        std::size_t find_free (std::size_t hash) const noexcept {
+            auto mask = groups_mask();
+            auto group = h1 (hash) & mask;
+
+            for (std::size_t step = 1; ; ++step) {
+                auto first = group * Group::width;
+
+                if (auto m = Group {ctrl + first}.match_free(); m != 0)
+                    return first + flat_detail::lowest_bit (m);
+
+                group = (group + step) & mask;
+            }
+        }
+
+        template <typename K>
+        void erase_ (K const& key) noexcept {
+            if (auto ind = find_index (hasher (key), key); ind != capacity_) {
+                erase_slot (ind);
+
+                if constexpr (Policy::shrinkRatio > 0) {
+                    shrink_if_sparse();
+                }
+            }
+        }
+
+        // сжатие - лишь экономия памяти: если не хватило памяти на новый
+        // массив, erase всё равно успешен
+        void shrink_if_sparse() noexcept {
+            if (capacity_ <= minCapacity)
+                return;
+
+            if (size() >= max_filled (capacity_) * Policy::shrinkRatio)
+                return;
+
+            try {
+                realloc_slots (capacity_for (size() * 2));
+            } catch (...) {}
+        }
+
+        void release() noexcept {
+            FlatHashSet tmp {hasher, keyEq, alloc()};
+            tmp.maxLoad = maxLoad;
+            tmp.rehashLog = rehashLog;
+            tmp.counters = counters;
+            swap (tmp);
+        }
+
+        template <typename Make>
+        std::size_t construct_unique (std::size_t hash, Make make) {
+            if (growthLeft == 0) {
+                grow();
+            }
+
+            auto ind = find_free (hash);
+            new (slots + ind) T (make());
+
+            growthLeft -= (ctrl[ind] == flat_detail::Empty);
+            ctrl[ind] = h2 (hash);
+            ++size_;
+
+            return ind;
+        }
+
+        // ячейку можно сделать пустой, только если в её группе уже есть пустая:
+        // тогда ни одна цепочка поиска не проходила через эту группу
+        void erase_slot (std::size_t ind) noexcept {
+            slots[ind].~T();
+            --size_;
+
+            auto first = ind / Group::width * Group::width;
+
+            if (Group {ctrl + first}.match_empty() != 0) {
+                ctrl[ind] = flat_detail::Empty;
+                ++growthLeft;
+            } else {
+                ctrl[ind] = flat_detail::Deleted;
+            }
+        }
+
+        std::size_t max_filled (std::size_t capacity) const noexcept {
+            return std::size_t (capacity * double (maxLoad));
+        }
+
+        std::size_t capacity_for (std::size_t count) const noexcept {
+            auto capacity = minCapacity;
+
+            while (max_filled (capacity) < count) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        void grow() {
+            auto newCapacity = capacity_ == 0 ? minCapacity : capacity_;
+
+            // если место съели удалённые ячейки - перестраиваем без роста
+            if (size_ * 2 >= max_filled (capacity_)) {
+                newCapacity *= 2;
+            }
+
+            // при малом max_load_factor удвоения может не хватить
+            auto needed = capacity_for (size_ + 1);
+            realloc_slots (newCapacity < needed ? needed : newCapacity);
+        }
+
+        void realloc_slots (std::size_t newCapacity) {
+            auto started = hash_detail::RehashLog::Clock::now();
+
+            FlatHashSet tmp {hasher, keyEq, alloc()};
+            tmp.maxLoad = maxLoad;
+            tmp.rehashLog = rehashLog;
+            tmp.counters = counters;
+
+            // если ячейки не выделятся, деструктор tmp освободит ctrl
+            CtrlAlloc ctrlAlloc {alloc()};
+            tmp.ctrl = std::allocator_traits<CtrlAlloc>::allocate (ctrlAlloc, newCapacity);
+            tmp.capacity_ = newCapacity;
+
+            for (std::size_t i = 0; i < newCapacity; ++i) {
+                tmp.ctrl[i] = flat_detail::Empty;
+            }
+
+            tmp.slots = tmp.mem_alloc (newCapacity);
+            tmp.growthLeft = max_filled (newCapacity);
+
+            for (std::size_t i = 0; i < capacity_; ++i) {
+                if (flat_detail::is_full (ctrl[i])) {
+                    tmp.construct_unique (hasher (slots[i]), [&] {
+                        return std::move (slots[i]);
+                    });
+                }
+            }
+
+            swap (tmp);
+            rehashLog.add (started);
+        }
+
+        void destroy_slots() noexcept {
+            for (std::size_t i = 0; i < capacity_; ++i) {
+                if (flat_detail::is_full (ctrl[i])) {
+                    slots[i].~T();
+                }
+            }
+
+            if (ctrl) {
+                CtrlAlloc ctrlAlloc {alloc()};
+                std::allocator_traits<CtrlAlloc>::deallocate (ctrlAlloc, ctrl, capacity_);
+            }
+            mem_free (slots, capacity_);
+        }
+
+        Alloc& alloc() noexcept {
+            return *this;
+        }
+
+        Alloc const& alloc() const noexcept {
+            return *this;
+        }
+
+        T* mem_alloc (std::size_t count) {
+            return AllocTraits::allocate (alloc(), count);
+        }
+
+        void mem_free (T* ptr, std::size_t count) noexcept {
+            if (ptr) {
+                AllocTraits::deallocate (alloc(), ptr, count);
+            }
+        }
+
+        void push_back (T const& value) {
+            add (value);
+        }
+
+        void push_back (T&& value) {
+            add (std::move (value));
+        }
+
+    private:
+        static constexpr std::size_t minCapacity = Group::width * 2;
+        static constexpr float maxLoadLimit = 0.875f;
+
+        Hash hasher{};
+        Eq keyEq{};
+        float maxLoad = maxLoadLimit;
+        hash_detail::RehashLog rehashLog{};
+        hash_detail::CountersFor<Policy> counters{};
+
+        ctrl_t* ctrl = nullptr;
+        T* slots = nullptr;
+
+        std::size_t capacity_ = 0;
+        std::size_t size_ = 0;
+        std::size_t growthLeft = 0;
+    };
+
+
+    template <typename T, typename Hash, typename Eq, typename Policy, typename Alloc>
+    void swap (FlatHashSet<T, Hash, Eq, Policy, Alloc>& lhs, FlatHashSet<T, Hash, Eq, Policy, Alloc>& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+
+
+    namespace pmr
+    {
+        template <
+            typename T
+          , typename Hash = Hasher<T>
+          , typename Eq = DefaultEqual<T>
+          , typename Policy = FlatHashPolicy
+        >
+        using FlatHashSet = data_struct::FlatHashSet<T, Hash, Eq, Policy, std::pmr::polymorphic_allocator<T>>;
+    }
+}
+
+#endif
@@ -1,13 +1,28 @@
 #ifndef MY_FORWARD_LIST_GUARD_H
 #define MY_FORWARD_LIST_GUARD_H
 
+#include <memory>
+#include <new>
 #include <utility>
+#include "allocator.h"
 #include "iterators.h"
 #include "my_algorithm.h"
+#include "node_pool.h"
 
 
 namespace flist_detail
 {
+    struct Head {
+        Head* next = nullptr;
+    };
+
+
+    template <typename T>
+    struct Node: public Head {
+        T value;
+    };
+
+
     template <typename T, typename C>
     struct IterImpl {
         using Container = C;
@@ -57,15 +72,13 @@ namespace flist_detail
 
 namespace data_struct
 {
-    template <typename T>
-    class FList {
-        struct Head {
-            Head* next = nullptr;
-        };
-
-        struct Node: public Head {
-            T value;
-        };
+    // узлы берутся у Alloc, пересвязанного на тип узла;
+    // распределитель без состояния места не занимает
+    template <typename T, typename Alloc = std::allocator<T>>
+    class FList : private alloc_detail::Rebind<Alloc, flist_detail::Node<T>> {
+        using Head = flist_detail::Head;
+        using Node = flist_detail::Node<T>;
+        using NodeAlloc = alloc_detail::Rebind<Alloc, Node>;
 
         using IterImpl = flist_detail::IterImpl<T, FList>;
         friend IterImpl;
@@ -74,50 +87,82 @@ namespace data_struct
     public:
         using iterator       = ForwardIterator<T, IterImpl, Mutable_tag>;
         using const_iterator = ForwardIterator<T, IterImpl, Const_tag>;
+        using allocator_type = Alloc;
 
     public:
-        FList() noexcept = default;
+        FList() noexcept (std::is_nothrow_default_constructible_v<NodeAlloc>) = default;
+
+        explicit FList (Alloc const& alloc) noexcept
+            : NodeAlloc (alloc)
+        {}
 
         FList (FList&& rhs) noexcept
-            : prevFirst (std::exchange (rhs.prevFirst, Head{}))
+            : NodeAlloc (std::move (rhs.node_alloc()))
+            , prevFirst (std::exchange (rhs.prevFirst, Head{}))
         {}
 
-        FList (FList const& rhs) {
-            algs::copy (rhs.begin(), rhs.end(), algs::inserter (*this, prev_begin()));
-        }
+        FList (FList const& rhs)
+            : FList (rhs, alloc_detail::select_for_copy (rhs.get_allocator()))
+        {}
+
+        FList (FList const& rhs, Alloc const& alloc)
+            : FList (rhs.begin(), rhs.end(), alloc)
+        {}
 
         template <class Iter, class = EnableIfForward<Iter>>
-        FList (Iter beg, Iter end) {
+        FList (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : FList (alloc)
+        {
             algs::copy (beg, end, algs::inserter (*this, prev_begin()));
         }
 
-        FList (std::initializer_list<T> iList) {
-            algs::copy (iList.begin(), iList.end(), algs::inserter (*this, prev_begin()));
-        }
+        FList (std::initializer_list<T> iList, Alloc const& alloc = Alloc{})
+            : FList (iList.begin(), iList.end(), alloc)
+        {}
 
-        FList (std::size_t count, T const& value = T()) {
+        FList (std::size_t count, T const& value = T(), Alloc const& alloc = Alloc{})
+            : FList (alloc)
+        {
             while (count--) {
                 push_front (value);
             }
         }
 
-        FList& operator= (FList&& rhs) noexcept {
-            if (this != &rhs) {
+        // узлы забираются, только если их можно вернуть через свой
+        // распределитель, иначе значения переносятся по одному
+        FList& operator= (FList&& rhs) noexcept (std::allocator_traits<NodeAlloc>::is_always_equal::value) {
+            if (this == &rhs)
+                return *this;
+
+            if (alloc_detail::can_take_storage (node_alloc(), rhs.node_alloc())) {
                 auto tmp = std::move (rhs);
                 swap (tmp);
-            } 
+            } else {
+                FList tmp (get_allocator());
+                auto it = tmp.prev_begin();
+                for (auto& el : rhs) {
+                    it = tmp.insert_after (it, std::move (el));
+                    ++it;
+                }
+                swap (tmp);
+            }
             return *this;
         }
 
         FList& operator= (FList const& rhs) {
             if (this != &rhs) {
-                auto tmp = rhs;
+                FList tmp {rhs, alloc_detail::for_copy_assign (get_allocator(), rhs.get_allocator())};
                 swap (tmp);
             }
             return *this;
         }
 
         ~FList() noexcept {
+            clear();
+        }
+
+        // узлы возвращаются распределителю; пул оставляет их себе
+        void clear() noexcept {
             while (not empty()) {
                 pop_front();
             }
@@ -128,8 +173,13 @@ namespace data_struct
         }
 
         void swap (FList& rhs) noexcept {
+            alloc_detail::swap (node_alloc(), rhs.node_alloc());
             std::swap(prevFirst, rhs.prevFirst);
         }
+
+        allocator_type get_allocator() const noexcept {
+            return Alloc (node_alloc());
+        }
         
         auto prev_begin() noexcept {
             return iterator {&prevFirst};
@@ -179,10 +229,11 @@ namespace data_struct
             auto pPrev = it.real();
             auto oldNext = pPrev->next;
 
-            pPrev->next = new Node {
-                oldNext
+            pPrev->next = alloc_detail::new_object (
+                node_alloc()
+              , oldNext
               , std::forward<Ts> (params)...
-            };
+            );
 
             return iterator {it.real()};
         }
@@ -209,13 +260,52 @@ namespace data_struct
         }
 
         void erase_after (const_iterator it) noexcept {
+            delete_node (extract_after (it));
+        }
+
+        // отцепляет узел, следующий за it, значение не трогается
+        Node* extract_after (const_iterator it) noexcept {
             auto pPrev = it.real();
             auto oldFirst = get_ptr_node (pPrev->next);
             pPrev->next = oldFirst->next;
+            oldFirst->next = nullptr;
 
-            delete (oldFirst);
+            return oldFirst;
         }
 
+        // вставляет после it узел, полученный через extract_after
+        iterator splice_after (const_iterator it, Node* node) noexcept {
+            auto pPrev = it.real();
+            node->next = pPrev->next;
+            pPrev->next = node;
+
+            return iterator {pPrev};
+        }
+
+        // узел в памяти вызывающего (например, в общем блоке для многих узлов);
+        // такой узел нельзя отдавать erase_after и деструктору списка:
+        // его забирают через extract_after и разрушают через destroy_node
+        template <typename... Ts>
+        static Node* construct_node (void* mem, Ts&&... params) {
+            return new (mem) Node {
+                nullptr
+              , std::forward<Ts> (params)...
+            };
+        }
+
+        static void destroy_node (Node* node) noexcept {
+            node->~Node();
+        }
+
+        // узел, полученный через extract_after из этого списка
+        // (или из списка с равным распределителем)
+        void delete_node (Node* node) noexcept {
+            alloc_detail::delete_object (node_alloc(), node);
+        }
+
+        static constexpr std::size_t nodeSize = sizeof(Node);
+        static constexpr std::size_t nodeAlign = alignof(Node);
+
         void pop_front() noexcept {
             erase_after (prev_begin());
         }
@@ -243,6 +333,14 @@ namespace data_struct
         }       
 
     private:
+        NodeAlloc& node_alloc() noexcept {
+            return *this;
+        }
+
+        NodeAlloc const& node_alloc() const noexcept {
+            return *this;
+        }
+
         static
         Head* no_const (Head const* pHead) noexcept {
             return const_cast<Head*> (pHead);
@@ -280,9 +378,21 @@ namespace data_struct
     };
 
 
-    template <typename T>
-    void swap (FList<T>& lhs, FList<T>& rhs) noexcept {
+    template <typename T, typename Alloc>
+    void swap (FList<T, Alloc>& lhs, FList<T, Alloc>& rhs) noexcept {
         lhs.swap (rhs);
     }
+
+
+    // узлы из слябов, без аллокации на каждую вставку
+    template <typename T>
+    using PooledFList = FList<T, NodePoolAllocator<T>>;
+
+
+    namespace pmr
+    {
+        template <typename T>
+        using FList = data_struct::FList<T, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 #endif
\ No newline at end of file
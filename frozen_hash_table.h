@@ -0,0 +1,515 @@
+#ifndef MY_FROZEN_HASH_TABLE_H_GUARD
+#define MY_FROZEN_HASH_TABLE_H_GUARD
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include "dynamic_array.h"
+#include "hash_table.h"
+
+namespace frozen_detail
+{
+    using u64 = std::uint64_t;
+
+    // средний размер корзины: меньше - быстрее сборка, больше - меньше пилотов
+    constexpr std::size_t keysPerBucket = 3;
+
+
+    constexpr std::size_t buckets_for (std::size_t count) noexcept {
+        return count / keysPerBucket + 1;
+    }
+
+
+    // позиции раскладываются на чуть большую таблицу (заполнение ~98%),
+    // иначе последние корзины перебирают пилоты пропорционально n.
+    // Ключи, попавшие за count, переносятся в свободные места через remap
+    constexpr std::size_t table_size (std::size_t count) noexcept {
+        return count + count / 64 + 1;
+    }
+
+
+    constexpr std::size_t scratch_size (std::size_t count, std::size_t bucketsCnt) noexcept {
+        return 2 * count + 2 * bucketsCnt + 3;
+    }
+
+
+    // x -> [0, n) по старшей половине произведения, без деления
+    constexpr std::size_t reduce (u64 x, std::size_t n) noexcept {
+        u64 b = n;
+        hash_detail::mum (x, b);
+        return std::size_t (b);
+    }
+
+
+    constexpr std::size_t bucket (u64 hash, std::size_t bucketsCnt) noexcept {
+        return reduce (hash, bucketsCnt);
+    }
+
+
+    constexpr std::size_t position (u64 hash, std::uint32_t pilot, std::size_t tableSize) noexcept {
+        return reduce (hash_detail::hash_int (hash, pilot), tableSize);
+    }
+
+
+    // номер ячейки в [0, count) для хеша; pilots и remap - любые массивы
+    template <typename Pilots, typename Remap>
+    constexpr std::size_t slot_index (
+        u64 hash, Pilots const& pilots, std::size_t bucketsCnt, Remap const& remap, std::size_t count
+    ) noexcept {
+        auto pos = position (hash, pilots[bucket (hash, bucketsCnt)], table_size (count));
+        return pos < count ? pos : remap[pos - count];
+    }
+
+
+    // минимальный идеальный хеш в духе PTHash: ключи делятся на корзины,
+    // для каждой корзины, начиная с самых больших, подбирается пилот, при
+    // котором все её ключи попадают в свободные позиции. Итог: pilots[bucketsCnt],
+    // remap[table_size - count] и order[table_size], где order[pos] для
+    // pos < count - номер ключа в ячейке pos.
+    // Только индексы и указатели, поэтому годится и для constexpr
+    constexpr void place (
+        u64 const* hashes, std::size_t count
+      , std::uint32_t* pilots, std::size_t bucketsCnt
+      , std::size_t* remap, std::size_t* order, std::size_t* scratch
+    ) {
+        auto tableSize = table_size (count);
+
+        auto start = scratch;                       // [bucketsCnt + 1]
+        auto members = start + bucketsCnt + 1;      // [count]
+        auto sorted = members + count;              // [bucketsCnt]
+        auto sizes = sorted + bucketsCnt;           // [count + 2]
+
+        for (std::size_t b = 0; b <= bucketsCnt; ++b) {
+            start[b] = 0;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            ++start[bucket (hashes[i], bucketsCnt) + 1];
+        }
+        for (std::size_t b = 0; b < bucketsCnt; ++b) {
+            start[b + 1] += start[b];
+            sorted[b] = start[b];
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            members[sorted[bucket (hashes[i], bucketsCnt)]++] = i;
+        }
+
+        // корзины по убыванию размера, сортировка подсчётом
+        for (std::size_t s = 0; s <= count + 1; ++s) {
+            sizes[s] = 0;
+        }
+        for (std::size_t b = 0; b < bucketsCnt; ++b) {
+            ++sizes[count - (start[b + 1] - start[b]) + 1];
+        }
+        for (std::size_t s = 0; s <= count; ++s) {
+            sizes[s + 1] += sizes[s];
+        }
+        for (std::size_t b = 0; b < bucketsCnt; ++b) {
+            sorted[sizes[count - (start[b + 1] - start[b])]++] = b;
+        }
+
+        for (std::size_t pos = 0; pos < tableSize; ++pos) {
+            order[pos] = count;
+        }
+
+        for (std::size_t k = 0; k < bucketsCnt; ++k) {
+            auto b = sorted[k];
+            auto first = members + start[b];
+            auto size = start[b + 1] - start[b];
+
+            pilots[b] = 0;
+            if (size == 0)
+                continue;
+
+            // при равных хешах никакой пилот их не разведёт
+            for (std::size_t i = 0; i < size; ++i) {
+                for (std::size_t j = i + 1; j < size; ++j) {
+                    if (hashes[first[i]] == hashes[first[j]]) throw std::runtime_error (
+                        "ключи с одинаковым хешем: повтор ключа или слабый Hasher\n"
+                    );
+                }
+            }
+
+            for (std::uint32_t pilot = 0; ; ++pilot) {
+                std::size_t placed = 0;
+
+                for (; placed < size; ++placed) {
+                    auto pos = position (hashes[first[placed]], pilot, tableSize);
+                    if (order[pos] != count)
+                        break;
+
+                    order[pos] = first[placed];
+                }
+
+                if (placed == size) {
+                    pilots[b] = pilot;
+                    break;
+                }
+
+                while (placed--) {
+                    order[position (hashes[first[placed]], pilot, tableSize)] = count;
+                }
+
+                if (pilot == std::uint32_t (-1)) throw std::runtime_error (
+                    "не удалось подобрать идеальный хеш\n"
+                );
+            }
+        }
+
+        std::size_t free = 0;
+        for (std::size_t pos = count; pos < tableSize; ++pos) {
+            remap[pos - count] = 0;
+            if (order[pos] == count)
+                continue;
+
+            while (order[free] != count) {
+                ++free;
+            }
+            order[free] = order[pos];
+            remap[pos - count] = free;
+        }
+    }
+}
+
+
+namespace data_struct
+{
+    // неизменяемое множество с минимальным идеальным хешем: элементы лежат
+    // подряд в массиве из size() ячеек, поиск - один хеш, одно чтение
+    // пилота (и изредка remap), одно сравнение. Сборка за O(n) в среднем, ключи должны быть
+    // различны (повтор даёт исключение)
+    template <typename T, typename Hash = Hasher<T>, typename Eq = DefaultEqual<T>>
+    class FrozenHashSet {
+        template <typename K>
+        using EnableIfTransparent = std::enable_if_t<
+            hash_detail::IsTransparent<Hash, K>::value
+        and hash_detail::IsTransparent<Eq, K>::value
+        >;
+
+    public:
+        using iterator       = typename DynamicArray<T>::const_iterator;
+        using const_iterator = iterator;
+
+    public:
+        FrozenHashSet() noexcept = default;
+
+        template <class Iter, class = EnableIfForward<Iter>>
+        FrozenHashSet (Iter beg, Iter end, Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : hasher (hash)
+            , keyEq (eq)
+        {
+            DynamicArray<T> staged {beg, end};
+            auto count = staged.size();
+
+            if (count == 0)
+                return;
+
+            DynamicArray<frozen_detail::u64> hashes;
+            hashes.reserve (count);
+            for (std::size_t i = 0; i < count; ++i) {
+                hashes.push_back (hasher (staged[i]));
+            }
+
+            auto bucketsCnt = frozen_detail::buckets_for (count);
+            auto tableSize = frozen_detail::table_size (count);
+            DynamicArray<std::uint32_t> newPilots (bucketsCnt);
+            DynamicArray<std::size_t> newRemap (tableSize - count);
+            DynamicArray<std::size_t> order (tableSize);
+            DynamicArray<std::size_t> scratch (frozen_detail::scratch_size (count, bucketsCnt));
+
+            frozen_detail::place (
+                &hashes[0], count, &newPilots[0], bucketsCnt, &newRemap[0], &order[0], &scratch[0]
+            );
+
+            DynamicArray<T> newSlots;
+            newSlots.reserve (count);
+            for (std::size_t pos = 0; pos < count; ++pos) {
+                newSlots.push_back (std::move (staged[order[pos]]));
+            }
+
+            pilots.swap (newPilots);
+            remap.swap (newRemap);
+            slots.swap (newSlots);
+        }
+
+        void swap (FrozenHashSet& rhs) noexcept {
+            std::swap (hasher, rhs.hasher);
+            std::swap (keyEq, rhs.keyEq);
+            pilots.swap (rhs.pilots);
+            remap.swap (rhs.remap);
+            slots.swap (rhs.slots);
+        }
+
+        bool empty() const noexcept {
+            return slots.empty();
+        }
+
+        std::size_t size() const noexcept {
+            return slots.size();
+        }
+
+        const_iterator begin() const noexcept {
+            return slots.begin();
+        }
+
+        const_iterator cbegin() const noexcept {
+            return slots.cbegin();
+        }
+
+        const_iterator end() const noexcept {
+            return slots.end();
+        }
+
+        const_iterator cend() const noexcept {
+            return slots.cend();
+        }
+
+        const_iterator find (T const& value) const {
+            return find_ (value);
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        const_iterator find (K const& key) const {
+            return find_ (key);
+        }
+
+        template <typename K = T>
+        bool contains (K const& key) const {
+            return find (key) != end();
+        }
+
+        // байты пилотов, переносов и ячеек
+        std::size_t memory_usage() const noexcept {
+            return pilots.capacity() * sizeof(std::uint32_t)
+                 + remap.capacity() * sizeof(std::size_t)
+                 + slots.capacity() * sizeof(T);
+        }
+
+    private:
+        template <typename K>
+        const_iterator find_ (K const& key) const {
+            if (slots.empty())
+                return end();
+
+            auto pos = frozen_detail::slot_index (hasher (key), pilots, pilots.size(), remap, slots.size());
+
+            if (not keyEq (key, slots[pos]))
+                return end();
+
+            return slots.cbegin() + pos;
+        }
+
+    private:
+        Hash hasher{};
+        Eq keyEq{};
+
+        DynamicArray<std::uint32_t> pilots;
+        DynamicArray<std::size_t> remap;
+        DynamicArray<T> slots;
+    };
+
+
+    template <typename T, typename Hash, typename Eq>
+    void swap (FrozenHashSet<T, Hash, Eq>& lhs, FrozenHashSet<T, Hash, Eq>& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+
+
+    // HashTable, замороженная после заполнения
+    template <
+        typename Key
+      , typename Value
+      , typename Hash = KeyValueHash<Key, Value>
+      , typename Eq = KeyValueEqual<Key, Value>
+    >
+    class FrozenHashTable {
+        using Elem = Pair<Key, Value>;
+        using Impl = FrozenHashSet<Elem, Hash, Eq>;
+
+    public:
+        using iterator       = typename Impl::iterator;
+        using const_iterator = typename Impl::const_iterator;
+
+    public:
+        FrozenHashTable() noexcept = default;
+
+        template <typename H, typename E, typename P, typename A>
+        explicit FrozenHashTable (HashTable<Key, Value, H, E, P, A> const& table, Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : impl (table.begin(), table.end(), hash, eq)
+        {}
+
+        template <class Iter, class = EnableIfForward<Iter>>
+        FrozenHashTable (Iter beg, Iter end, Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : impl (beg, end, hash, eq)
+        {}
+
+        void swap (FrozenHashTable& rhs) noexcept {
+            impl.swap (rhs.impl);
+        }
+
+        bool empty() const noexcept {
+            return impl.empty();
+        }
+
+        std::size_t size() const noexcept {
+            return impl.size();
+        }
+
+        auto begin() const noexcept {
+            return impl.begin();
+        }
+
+        auto cbegin() const noexcept {
+            return impl.cbegin();
+        }
+
+        auto end() const noexcept {
+            return impl.end();
+        }
+
+        auto cend() const noexcept {
+            return impl.cend();
+        }
+
+        template <typename K = Key>
+        const_iterator find (K const& key) const {
+            return impl.find (key);
+        }
+
+        template <typename K = Key>
+        bool contains (K const& key) const {
+            return find (key) != end();
+        }
+
+        template <typename K = Key>
+        Value const& operator[] (K const& key) const {
+            auto it = find (key);
+
+            if (it == end()) throw std::runtime_error (
+                "не существует элемента с таким ключом\n"
+            );
+
+            return it->second;
+        }
+
+        std::size_t memory_usage() const noexcept {
+            return impl.memory_usage();
+        }
+
+    private:
+        Impl impl;
+    };
+
+
+    template <typename Key, typename Value, typename Hash, typename Eq>
+    void swap (FrozenHashTable<Key, Value, Hash, Eq>& lhs, FrozenHashTable<Key, Value, Hash, Eq>& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+
+
+    // вариант для набора ключей, известного при компиляции: строится
+    // make_frozen_table в constexpr, хранится в std::array без аллокаций.
+    // Hasher и сравнение ключей должны быть constexpr (целые, string_view)
+    template <
+        typename Key
+      , typename Value
+      , std::size_t N
+      , typename Hash = KeyValueHash<Key, Value>
+      , typename Eq = KeyValueEqual<Key, Value>
+    >
+    class ConstFrozenHashTable {
+        using Elem = Pair<Key, Value>;
+
+        static constexpr std::size_t bucketsCnt = frozen_detail::buckets_for (N);
+        static constexpr std::size_t tableSize = frozen_detail::table_size (N);
+
+    public:
+        using iterator       = Elem const*;
+        using const_iterator = Elem const*;
+
+    public:
+        constexpr ConstFrozenHashTable (Elem const (&items)[N], Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : hasher (hash)
+            , keyEq (eq)
+        {
+            std::array<frozen_detail::u64, N> hashes{};
+            for (std::size_t i = 0; i < N; ++i) {
+                hashes[i] = hasher (items[i]);
+            }
+
+            std::array<std::size_t, tableSize> order{};
+            std::array<std::size_t, frozen_detail::scratch_size (N, bucketsCnt)> scratch{};
+            frozen_detail::place (
+                hashes.data(), N, pilots.data(), bucketsCnt, remap.data(), order.data(), scratch.data()
+            );
+
+            for (std::size_t pos = 0; pos < N; ++pos) {
+                slots[pos] = items[order[pos]];
+            }
+        }
+
+        constexpr bool empty() const noexcept {
+            return N == 0;
+        }
+
+        constexpr std::size_t size() const noexcept {
+            return N;
+        }
+
+        constexpr const_iterator begin() const noexcept {
+            return slots.data();
+        }
+
+        constexpr const_iterator end() const noexcept {
+            return slots.data() + N;
+        }
+
+        template <typename K = Key>
+        constexpr const_iterator find (K const& key) const {
+            if (N == 0)
+                return end();
+
+            auto pos = frozen_detail::slot_index (hasher (key), pilots, bucketsCnt, remap, N);
+
+            if (not keyEq (key, slots[pos]))
+                return end();
+
+            return slots.data() + pos;
+        }
+
+        template <typename K = Key>
+        constexpr bool contains (K const& key) const {
+            return find (key) != end();
+        }
+
+        template <typename K = Key>
+        constexpr Value const& operator[] (K const& key) const {
+            auto it = find (key);
+
+            if (it == end()) throw std::runtime_error (
+                "не существует элемента с таким ключом\n"
+            );
+
+            return it->second;
+        }
+
+    private:
+        Hash hasher{};
+        Eq keyEq{};
+
+        std::array<std::uint32_t, bucketsCnt> pilots{};
+        std::array<std::size_t, tableSize - N> remap{};
+        std::array<Elem, N> slots{};
+    };
+
+
+    // constexpr auto colors = make_frozen_table<std::string_view, int> ({
+    //     {"red", 1}, {"green", 2}, {"blue", 3}
+    // });
+    template <typename Key, typename Value, std::size_t N>
+    constexpr auto make_frozen_table (Pair<Key, Value> const (&items)[N]) {
+        return ConstFrozenHashTable<Key, Value, N> {items};
+    }
+}
+
+#endif
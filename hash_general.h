@@ -0,0 +1,198 @@
+#ifndef MY_HASH_GENERAL_H_GUARD
+#define MY_HASH_GENERAL_H_GUARD
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <xmmintrin.h>
+#endif
+
+namespace hash_detail
+{
+    // поиск по типу, отличному от хранимого (std::string_view для std::string),
+    // разрешается, если и Hash, и Eq объявляют is_transparent
+    template <typename F, typename K, typename = void>
+    struct IsTransparent : std::false_type {};
+
+
+    template <typename F, typename K>
+    struct IsTransparent<F, K, std::void_t<typename F::is_transparent>>
+        : std::true_type
+    {};
+
+
+    // копирующая инициализация из LazyValue вызывает make() и строит
+    // результат сразу на месте, без промежуточного объекта
+    template <typename Make>
+    struct LazyValue {
+        operator decltype (std::declval<Make&>()()) () {
+            return make();
+        }
+
+        Make& make;
+    };
+
+
+    // столько ключей find_batch хеширует и предвыбирает за один проход:
+    // промахи по ним идут параллельно, а данные не успевают вытесниться
+    constexpr std::size_t lookupBatch = 16;
+
+
+    inline void prefetch (void const* ptr) noexcept {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        _mm_prefetch (static_cast<char const*> (ptr), _MM_HINT_T0);
+    #else
+        __builtin_prefetch (ptr);
+    #endif
+    }
+
+
+    // меньше минимума корзин или ячеек нужно больше, чем size_t вмещает,
+    // а при нуле, NaN или бесконечности их число не вычисляется вовсе -
+    // вставка зацикливалась бы
+    constexpr float minMaxLoad = 1.f / 1024;
+
+
+    inline void check_max_load (float factor) {
+        if (not (factor >= minMaxLoad) or not std::isfinite (factor)) throw std::invalid_argument (
+            "max_load_factor должен быть конечным и не меньше 1/1024\n"
+        );
+    }
+}
+
+
+namespace data_struct
+{
+    // специализации для встроенных типов и строк - в hasher.h
+    template <typename T, typename = void>
+    struct Hasher;
+
+
+    template <typename T>
+    struct DefaultEqual {
+        using is_transparent = void;
+
+        bool operator() (T const& t1, T const& t2) const {
+            return t1 == t2;
+        }
+
+        template <typename U, typename = decltype (std::declval<U const&>() == std::declval<T const&>())>
+        bool operator() (U const& u, T const& t) const {
+            return u == t;
+        }
+    };
+
+
+    // способ хранения элементов в хеш-множестве
+    struct ChainedBuckets {};   // массив корзин, в каждой корзине FList
+    struct OpenAddressing {};   // плоский массив + управляющие байты (swiss table)
+
+
+    // отображение хеша в номер корзины, fit подбирает допустимое число корзин
+    struct ModuloIndex {
+        static std::size_t fit (std::size_t count) noexcept {
+            return count;
+        }
+
+        void reset (std::size_t count) noexcept {
+            buckets = count;
+        }
+
+        std::size_t operator() (std::size_t hash) const noexcept {
+            return hash % buckets;
+        }
+
+        std::size_t buckets = 1;
+    };
+
+
+    // корзин - степень двойки, номер корзины - старшие биты hash * 2^64/φ:
+    // деления нет, а умножение перемешивает даже слабый хеш
+    struct FibonacciIndex {
+        static std::size_t fit (std::size_t count) noexcept {
+            std::size_t res = 2;
+            while (res < count) {
+                res *= 2;
+            }
+            return res;
+        }
+
+        void reset (std::size_t count) noexcept {
+            for (shift = 64; count > 1; count /= 2) {
+                --shift;
+            }
+        }
+
+        std::size_t operator() (std::size_t hash) const noexcept {
+            return std::size_t ((std::uint64_t (hash) * 0x9E3779B97F4A7C15ull) >> shift);
+        }
+
+        unsigned shift = 63;
+    };
+
+
+    // фильтр перед поиском в корзине отключён: пропускает любой хеш.
+    // Фильтр с настоящей отсечкой - BlockedBloomFilter из bloom_filter.h
+    struct NoFilter {
+        void reset (std::size_t) noexcept {}
+        void add (std::size_t) noexcept {}
+
+        bool may_contain (std::size_t) const noexcept {
+            return true;
+        }
+
+        std::size_t memory_usage() const noexcept {
+            return 0;
+        }
+
+        void swap (NoFilter&) noexcept {}
+    };
+
+
+    struct DefaultHashPolicy {
+        using Layout = ChainedBuckets;
+        using BucketIndex = ModuloIndex;
+
+        // рост массива корзин частями: за одну вставку переносится
+        // ограниченное число корзин, старый и новый массивы живут вместе
+        static constexpr bool incrementalRehash = false;
+
+        // хранить полный хеш рядом с элементом: рехеширование не вызывает Hash,
+        // а поиск сравнивает хеши до вызова Eq
+        static constexpr bool cacheHash = false;
+
+        // только для ChainedBuckets: в FlatHashSet промах и так
+        // отсекается по управляющим байтам
+        using Filter = NoFilter;
+
+        // счётчики поисков, попаданий и сравнений для stats()
+        static constexpr bool countOps = false;
+
+        // после erase: если заполнено меньше shrinkRatio от max_load_factor,
+        // таблица сжимается до половинной загрузки (запас от повторного роста),
+        // и erase может сделать итераторы недействительными. 0 - не сжимать
+        static constexpr float shrinkRatio = 0;
+    };
+
+
+    struct IncrementalHashPolicy : DefaultHashPolicy {
+        static constexpr bool incrementalRehash = true;
+    };
+
+
+    struct AutoShrinkHashPolicy : DefaultHashPolicy {
+        static constexpr float shrinkRatio = 0.125f;
+    };
+
+
+    struct FlatHashPolicy : DefaultHashPolicy {
+        using Layout = OpenAddressing;
+    };
+}
+
+#endif
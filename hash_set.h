@@ -1,12 +1,143 @@
 #ifndef MY_HASH_SET_H_GUARD
 #define MY_HASH_SET_H_GUARD
 
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <thread>
+#include "allocator.h"
 #include "dynamic_array.h"
+#include "flat_hash_set.h"
 #include "flist.h"
+#include "hash_general.h"
+#include "hasher.h"
+#include "hash_stats.h"
 
 
 namespace hashset_detail
 {
+    template <std::size_t size, std::size_t align>
+    struct alignas(align) NodeSlot {
+        unsigned char bytes[size];
+    };
+
+
+    // один блок под count узлов размера size; узлы из него не освобождаются
+    // по одному - память уходит целиком вместе с блоком
+    template <std::size_t size, std::size_t align, typename Alloc>
+    class NodeArena : private alloc_detail::Rebind<Alloc, NodeSlot<size, align>> {
+        using Slot = NodeSlot<size, align>;
+        using SlotAlloc = alloc_detail::Rebind<Alloc, Slot>;
+        using Traits = std::allocator_traits<SlotAlloc>;
+
+    public:
+        NodeArena() noexcept (std::is_nothrow_default_constructible_v<SlotAlloc>) = default;
+
+        explicit NodeArena (Alloc const& alloc, std::size_t count = 0)
+            : SlotAlloc (alloc)
+            , mem (count == 0 ? nullptr : Traits::allocate (slot_alloc(), count))
+            , count_ (count)
+        {}
+
+        NodeArena (NodeArena&& rhs) noexcept
+            : SlotAlloc (std::move (rhs.slot_alloc()))
+            , mem (std::exchange (rhs.mem, nullptr))
+            , count_ (std::exchange (rhs.count_, 0))
+        {}
+
+        NodeArena& operator= (NodeArena&& rhs) noexcept {
+            NodeArena tmp {std::move (rhs)};
+            swap (tmp);
+            return *this;
+        }
+
+        ~NodeArena() noexcept {
+            if (mem) {
+                Traits::deallocate (slot_alloc(), mem, count_);
+            }
+        }
+
+        void swap (NodeArena& rhs) noexcept {
+            alloc_detail::swap (slot_alloc(), rhs.slot_alloc());
+            std::swap (mem, rhs.mem);
+            std::swap (count_, rhs.count_);
+        }
+
+        bool empty() const noexcept {
+            return mem == nullptr;
+        }
+
+        void* slot (std::size_t ind) const noexcept {
+            return mem + ind;
+        }
+
+        bool owns (void const* ptr) const noexcept {
+            auto addr = reinterpret_cast<std::uintptr_t> (ptr);
+            auto first = reinterpret_cast<std::uintptr_t> (mem);
+            return mem != nullptr and addr >= first and addr < first + count_ * size;
+        }
+
+    private:
+        SlotAlloc& slot_alloc() noexcept {
+            return *this;
+        }
+
+    private:
+        Slot* mem = nullptr;
+        std::size_t count_ = 0;
+    };
+
+
+    // f (worker) для worker из [0, workers): последний - в текущем потоке.
+    // Первое исключение из рабочих потоков пробрасывается после join
+    template <typename F>
+    void run_parallel (std::size_t workers, F f) {
+        data_struct::DynamicArray<std::thread> threads;
+        data_struct::DynamicArray<std::exception_ptr> errors;
+        errors.resize (workers);
+
+        for (std::size_t w = 0; w + 1 < workers; ++w) {
+            threads.emplace_back ([&, w] {
+                try {
+                    f (w);
+                } catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+        }
+
+        try {
+            f (workers - 1);
+        } catch (...) {
+            errors[workers - 1] = std::current_exception();
+        }
+
+        for (std::size_t w = 0; w < threads.size(); ++w) {
+            threads[w].join();
+        }
+
+        for (std::size_t w = 0; w < workers; ++w) {
+            if (errors[w]) {
+                std::rethrow_exception (errors[w]);
+            }
+        }
+    }
+
+
+    template <typename T, bool cacheHash>
+    struct Entry {
+        T value;
+    };
+
+
+    template <typename T>
+    struct Entry<T, true> {
+        T value;
+        std::size_t hash;
+    };
+
+
     template <typename T, typename C>
     struct IterImpl {
         using Container = C;
@@ -26,27 +157,38 @@ namespace hashset_detail
             return prevElemIt == rhs.prevElemIt;
         }
 
-        void next() noexcept {               
+        void next() noexcept {
             ++prevElemIt;
 
-            if (not is_end()) 
+            if (not is_end())
                 return;
-                
-            while (++bucketIt != endIt and bucketIt->empty())
-                ;
 
-            if (bucketIt != endIt) {
-                prevElemIt = bucketIt->prev_begin();
-            }           
+            ++bucketIt;
+            skip_empty();
         }
 
         auto& get_value() const noexcept {
-            return *elem_it();
+            return elem_it()->value;
         }
-        
-    private:
-        auto elem_it() const noexcept {
-            return next_iter(prevElemIt);
+
+        // во время постепенного рехеширования обходятся оба массива корзин:
+        // сначала старый, затем новый
+        void skip_empty() noexcept {
+            while (true) {
+                bucketIt = algs::find_if (bucketIt, endIt, [] (auto& bucket) {
+                    return not bucket.empty();
+                });
+
+                if (bucketIt != endIt or nextIt == nextEndIt)
+                    break;
+
+                bucketIt = std::exchange (nextIt, nextEndIt);
+                endIt = nextEndIt;
+            }
+
+            if (bucketIt != endIt) {
+                prevElemIt = bucketIt->prev_begin();
+            }
         }
 
         bool is_end() const noexcept {
@@ -54,32 +196,43 @@ namespace hashset_detail
                 or elem_it() == bucketIt->end();
         }
 
+    private:
+        auto elem_it() const noexcept {
+            return next_iter(prevElemIt);
+        }
+
     public:
         buckets_iterator  bucketIt{};
         buckets_iterator  endIt{};
         elements_iterator prevElemIt{};
+
+        buckets_iterator  nextIt{};
+        buckets_iterator  nextEndIt{};
     };
 } 
 
 
 namespace data_struct
 {
-    template <typename T>
-    struct Hasher;
-
-
-    template <typename T>
-    struct DefaultEqual {
-        bool operator() (T const& t1, T const& t2) const {
-            return t1 == t2;
-        }
-    };
-
-
-    template <typename T, typename Hash = Hasher<T>, typename Eq = DefaultEqual<T>>
+    // Policy::Layout выбирает движок: ChainedBuckets - этот класс,
+    // OpenAddressing - FlatHashSet (специализация ниже).
+    // Узлы, корзины и блок узлов копии берутся у Alloc (пересвязанного),
+    // память фильтра - нет. Распределитель хранится в массиве корзин
+    template <
+        typename T
+      , typename Hash = Hasher<T>
+      , typename Eq = DefaultEqual<T>
+      , typename Policy = DefaultHashPolicy
+      , typename Alloc = std::allocator<T>
+      , typename Layout = typename Policy::Layout
+    >
     class HashSet {
-        using Bucket = FList<T>;
-        using Array  = DynamicArray<Bucket>;
+        using Entry  = hashset_detail::Entry<T, Policy::cacheHash>;
+        using Index  = typename Policy::BucketIndex;
+        using Bucket = FList<Entry, alloc_detail::Rebind<Alloc, Entry>>;
+        using Array  = DynamicArray<Bucket, alloc_detail::Rebind<Alloc, Bucket>>;
+        using Filter = typename Policy::Filter;
+        using Counters = hash_detail::CountersFor<Policy>;
 
         using buckets_iterator  = typename Array::iterator;
         using elements_iterator = typename Bucket::iterator;
@@ -90,6 +243,11 @@ namespace data_struct
         friend IterImpl;
         friend BackIns;
 
+        static_assert (
+            std::is_same_v<Layout, ChainedBuckets>
+          , "Policy::Layout - ChainedBuckets или OpenAddressing"
+        );
+
 
         template <typename T1>
         using EnableIfIsT = std::enable_if_t<
@@ -97,46 +255,128 @@ namespace data_struct
          or std::is_constructible_v<T, T1>
         >;
 
+        template <typename K>
+        using EnableIfTransparent = std::enable_if_t<
+            hash_detail::IsTransparent<Hash, K>::value
+        and hash_detail::IsTransparent<Eq, K>::value
+        >;
+
     public:
         using iterator       = ForwardIterator<T, IterImpl, Mutable_tag>;
         using const_iterator = ForwardIterator<T, IterImpl, Const_tag>;
+        using allocator_type = Alloc;
 
     public:
-        HashSet() noexcept = default;
-        ~HashSet() noexcept = default;
+        HashSet() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+
+        ~HashSet() noexcept {
+            if (not arena.empty()) {
+                release_nodes();
+            }
+        }
+
+        explicit HashSet (Alloc const& alloc)
+            : array (alloc)
+            , oldArray (alloc)
+            , arena (alloc)
+        {}
+
+        explicit HashSet (Hash const& hash, Eq const& eq = Eq{}, Alloc const& alloc = Alloc{})
+            : hasher (hash)
+            , keyEq (eq)
+            , array (alloc)
+            , oldArray (alloc)
+            , arena (alloc)
+        {}
 
         HashSet (HashSet&& rhs) noexcept
-            : array (std::move (rhs.array))
+            : hasher (rhs.hasher)
+            , keyEq (rhs.keyEq)
+            , maxLoad (rhs.maxLoad)
+            , index (rhs.index)
+            , oldIndex (rhs.oldIndex)
+            , array (std::move (rhs.array))
+            , oldArray (std::move (rhs.oldArray))
+            , filter (std::move (rhs.filter))
+            , oldFilter (std::move (rhs.oldFilter))
+            , rehashLog (rhs.rehashLog)
+            , counters (rhs.counters)
+            , migrated (std::exchange (rhs.migrated, 0))
             , size_ (std::exchange (rhs.size_, 0))
+            , arena (std::move (rhs.arena))
         {}
 
-        HashSet (HashSet const& rhs) noexcept
-            : array (rhs.array)
-            , size_ (rhs.size_)
+        // все узлы копии - в одном блоке, раскладка по корзинам та же,
+        // что у rhs, поэтому хеши не считаются
+        HashSet (HashSet const& rhs)
+            : HashSet (rhs, alloc_detail::select_for_copy (rhs.get_allocator()))
         {}
 
+        HashSet (HashSet const& rhs, Alloc const& alloc)
+            : hasher (rhs.hasher)
+            , keyEq (rhs.keyEq)
+            , maxLoad (rhs.maxLoad)
+            , index (rhs.index)
+            , oldIndex (rhs.oldIndex)
+            , array (make_buckets (rhs.array.size(), alloc))
+            , oldArray (make_buckets (rhs.oldArray.size(), array.get_allocator()))
+            , filter (rhs.filter)
+            , oldFilter (rhs.oldFilter)
+            , rehashLog (rhs.rehashLog)
+            , counters (rhs.counters)
+            , migrated (rhs.migrated)
+            , size_ (rhs.size_)
+            , arena (alloc, rhs.size_)
+        {
+            try {
+                std::size_t used = 0;
+                clone_buckets (array, rhs.array, used);
+                clone_buckets (oldArray, rhs.oldArray, used);
+            } catch (...) {
+                release_nodes();
+                throw;
+            }
+        }
+
         template <class Iter, class = EnableIfForward<Iter>>
-        HashSet (Iter beg, Iter end) {
-            algs::copy (beg, end, algs::back_inserter (*this));
+        HashSet (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : HashSet (alloc)
+        {
+            insert (beg, end);
         }
 
-        HashSet (std::initializer_list<T> iList) {
+        HashSet (std::initializer_list<T> iList, Alloc const& alloc = Alloc{})
+            : HashSet (alloc)
+        {
             algs::copy (iList.begin(), iList.end(), BackIns (*this));
         }
 
+        // узлы забираются, только если их можно вернуть через свой
+        // распределитель, иначе элементы переносятся по одному
         HashSet& operator= (HashSet&& rhs)
         {
-            if (this == &rhs) {
+            if (this == &rhs)
+                return *this;
+
+            if (alloc_detail::can_take_storage (get_allocator(), rhs.get_allocator())) {
                 auto tmp {std::move (rhs)};
                 swap (tmp);
+            } else {
+                HashSet tmp {rhs.hasher, rhs.keyEq, get_allocator()};
+                tmp.maxLoad = rhs.maxLoad;
+                tmp.reserve (rhs.size());
+                for (auto& el : rhs) {
+                    tmp.add (std::move (el));
+                }
+                swap (tmp);
             }
             return *this;
         }
 
         HashSet& operator= (HashSet const& rhs)
         {
-            if (this == &rhs) {
-                auto tmp {rhs};
+            if (this != &rhs) {
+                HashSet tmp {rhs, alloc_detail::for_copy_assign (get_allocator(), rhs.get_allocator())};
                 swap (tmp);
             }
             return *this;
@@ -145,10 +385,34 @@ namespace data_struct
         void swap (HashSet& rhs) noexcept {
             using std::swap;
 
+            swap (hasher, rhs.hasher);
+            swap (keyEq, rhs.keyEq);
+            swap (maxLoad, rhs.maxLoad);
+            swap (index, rhs.index);
+            swap (oldIndex, rhs.oldIndex);
             swap (array, rhs.array);
+            swap (oldArray, rhs.oldArray);
+            swap (filter, rhs.filter);
+            swap (oldFilter, rhs.oldFilter);
+            swap (rehashLog, rhs.rehashLog);
+            swap (counters, rhs.counters);
+            arena.swap (rhs.arena);
+            swap (migrated, rhs.migrated);
             swap (size_, rhs.size_);
         }
 
+        allocator_type get_allocator() const noexcept {
+            return Alloc (array.get_allocator());
+        }
+
+        Hash const& hash_function() const noexcept {
+            return hasher;
+        }
+
+        Eq const& key_eq() const noexcept {
+            return keyEq;
+        }
+
         bool empty() const noexcept {
             return size() == 0;
         }
@@ -170,14 +434,11 @@ namespace data_struct
         }
 
         iterator end() noexcept {
-            return IterImpl {
-                array.end(), array.end(), elements_iterator{}
-            };
+            return end_iter_impl();
         }
 
         const_iterator cend() const noexcept {
-            auto [beg, end] = begin_end();
-            return IterImpl {end, end, elements_iterator{}};
+            return end_iter_impl();
         }
 
         const_iterator end() const noexcept {
@@ -185,94 +446,623 @@ namespace data_struct
         }
 
         void erase (T const& value) noexcept {
-            if (auto it = find (value); it != end()) {
-                auto [bucketIt, prevIt] = it.real();
+            erase_ (value);
+        }
 
-                bucketIt->erase_after (prevIt);
-                --size_;
-            }
+        template <typename K, typename = EnableIfTransparent<K>>
+        void erase (K const& key) noexcept {
+            erase_ (key);
         }
 
         template <class T1, class = EnableIfIsT<T1>>
-        void add (T1&& value) {
-            if (size() >= buckets_cnt() * middleMaxDepth) {
-                refill();
+        Pair<iterator, bool> add (T1&& value) {
+            return lazy_emplace (value, [&] {
+                return T (std::forward<T1> (value));
+            });
+        }
+
+        template <typename... Ts>
+        Pair<iterator, bool> emplace (Ts&&... params) {
+            T value {std::forward<Ts> (params)...};
+
+            return lazy_emplace (value, [&] {
+                return std::move (value);
+            });
+        }
+
+        // место под весь диапазон выделяется заранее, рехеширований по ходу нет
+        template <class Iter, class = EnableIfForward<Iter>>
+        void insert (Iter beg, Iter end) {
+            std::size_t count = 0;
+            for (auto it = beg; it != end; ++it) {
+                ++count;
             }
 
-            if (auto pos = find (value); pos == end()) {
-                push_to_bucket (std::forward<T1> (value));
+            reserve (size() + count);
+            for (; beg != end; ++beg) {
+                add (*beg);
             }
         }
 
+        // параллельная вставка диапазона с произвольным доступом:
+        // корзины делятся на threads непрерывных частей, каждый поток
+        // сначала хеширует свою долю входа и раскладывает её по частям,
+        // затем заполняет только корзины своей части - без блокировок.
+        // Чужой распределитель (арена, пул) не обязан быть потокобезопасным,
+        // с ним вставка идёт в одном потоке
+        template <typename RandomIt>
+        void build (RandomIt beg, RandomIt end, std::size_t threads = std::thread::hardware_concurrency()) {
+            std::size_t count = end - beg;
+
+            if constexpr (not std::is_same_v<Alloc, std::allocator<T>>) {
+                threads = 1;
+            }
+
+            reserve (size() + count);
+            migrate (oldArray.size());
+
+            if (threads < 2 or count < minParallelBuild) {
+                insert (beg, end);
+                return;
+            }
+
+            DynamicArray<std::size_t> hashes;
+            DynamicArray<std::size_t> order;
+            DynamicArray<std::size_t> counts;   // [поток][часть]
+            DynamicArray<std::size_t> added;
+            hashes.resize (count);
+            order.resize (count);
+            counts.resize (threads * threads);
+            added.resize (threads);
+
+            auto chunk_begin = [&] (std::size_t w) {
+                return count * w / threads;
+            };
+            auto part_of = [&] (std::size_t hash) {
+                return index (hash) * threads / buckets_cnt();
+            };
+
+            hashset_detail::run_parallel (threads, [&] (std::size_t w) {
+                for (auto i = chunk_begin (w); i != chunk_begin (w + 1); ++i) {
+                    hashes[i] = hasher (beg[i]);
+                    ++counts[w * threads + part_of (hashes[i])];
+                }
+            });
+
+            // позиции в order: части по порядку, внутри части - доли потоков
+            std::size_t offset = 0;
+            for (std::size_t part = 0; part < threads; ++part) {
+                for (std::size_t w = 0; w < threads; ++w) {
+                    offset += std::exchange (counts[w * threads + part], offset);
+                }
+            }
+
+            hashset_detail::run_parallel (threads, [&] (std::size_t w) {
+                for (auto i = chunk_begin (w); i != chunk_begin (w + 1); ++i) {
+                    order[counts[w * threads + part_of (hashes[i])]++] = i;
+                }
+            });
+
+            // после раскладки counts[(threads - 1) * threads + part] - конец части
+            auto run_part = [&] (std::size_t part) {
+                std::size_t first = part == 0 ? 0 : counts[(threads - 1) * threads + part - 1];
+                std::size_t last = counts[(threads - 1) * threads + part];
+
+                for (auto pos = first; pos != last; ++pos) {
+                    auto i = order[pos];
+                    auto hash = hashes[i];
+
+                    if (find_in_array (array, index, hash, beg[i]).is_end()) {
+                        emplace_to_bucket (array[index (hash)], hash, beg[i]);
+                        ++added[part];
+                    }
+                }
+            };
+
+            try {
+                hashset_detail::run_parallel (threads, run_part);
+            } catch (...) {
+                commit_build (hashes, added);
+                throw;
+            }
+            commit_build (hashes, added);
+        }
+
+        // если элемента, равного key, нет - вставляет результат make(),
+        // построенный прямо в узле списка
+        template <typename K, typename Make>
+        Pair<iterator, bool> lazy_emplace (K const& key, Make make) {
+            reserve_before_insert();
+
+            auto hash = hasher (key);
+
+            if (auto impl = find_ (hash, key); not impl.is_end())
+                return {impl, false};
+
+            auto value = hash_detail::LazyValue<Make> {make};
+            return {push_to_bucket (hash, std::move (value)), true};
+        }
+
         iterator find (T const& value) noexcept {
-            return find_ (value);
+            return find_ (hasher (value), value);
         }
 
         const_iterator find (T const& value) const noexcept {
-            return find_ (value);
+            return find_ (hasher (value), value);
         };
 
+        template <typename K, typename = EnableIfTransparent<K>>
+        iterator find (K const& key) noexcept {
+            return find_ (hasher (key), key);
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        const_iterator find (K const& key) const noexcept {
+            return find_ (hasher (key), key);
+        }
+
+        // результат поиска каждого ключа из [beg, end) пишется в out;
+        // ключи обрабатываются пачками: сначала все хеши и предвыборка
+        // корзин, затем предвыборка первых узлов, и только потом поиск
+        template <typename It, typename OutIt>
+        OutIt find_batch (It beg, It end, OutIt out) noexcept {
+            lookup_batch (beg, end, [&] (IterImpl const& impl) {
+                *out = iterator {impl};
+                ++out;
+            });
+            return out;
+        }
+
+        template <typename It, typename OutIt>
+        OutIt find_batch (It beg, It end, OutIt out) const noexcept {
+            lookup_batch (beg, end, [&] (IterImpl const& impl) {
+                *out = const_iterator {impl};
+                ++out;
+            });
+            return out;
+        }
+
+        template <typename It, typename OutIt>
+        OutIt contains_batch (It beg, It end, OutIt out) const noexcept {
+            lookup_batch (beg, end, [&] (IterImpl const& impl) {
+                *out = not impl.is_end();
+                ++out;
+            });
+            return out;
+        }
+
+        std::size_t bucket_count() const noexcept {
+            return buckets_cnt();
+        }
+
+        float load_factor() const noexcept {
+            return empty() ? 0.f : float (size()) / buckets_cnt();
+        }
+
+        float max_load_factor() const noexcept {
+            return maxLoad;
+        }
+
+        // новое значение учитывается при следующей вставке
+        void max_load_factor (float factor) {
+            hash_detail::check_max_load (factor);
+            maxLoad = factor;
+        }
+
+        // корзин станет не меньше count и не меньше, чем нужно для size()
+        void rehash (std::size_t count) {
+            auto needed = buckets_for (size());
+            auto newBucketCnt = Index::fit (count < needed ? needed : count);
+
+            if (newBucketCnt != 0 and newBucketCnt != buckets_cnt()) {
+                rebuild (newBucketCnt);
+            }
+        }
+
+        // вставка count элементов не вызовет рехеширования
+        void reserve (std::size_t count) {
+            rehash (buckets_for (count));
+        }
+
+        // число корзин - по текущему размеру, пустое множество освобождает всё
+        void shrink_to_fit() {
+            if (empty()) {
+                migrate (oldArray.size());
+                array = Array (array.get_allocator());
+                filter = Filter{};
+                return;
+            }
+
+            auto newBucketCnt = Index::fit (buckets_for (size()));
+            if (newBucketCnt < buckets_cnt()) {
+                rebuild (newBucketCnt);
+            }
+        }
+
+        // глубина корзин (и старого массива во время переноса), перестроения, память
+        HashStats stats() const {
+            struct NodeLayout {
+                void* next;
+                Entry entry;
+            };
+
+            HashStats res;
+            res.size = size();
+            res.bucketCount = buckets_cnt();
+            res.loadFactor = load_factor();
+
+            for (auto arr : {&array, &oldArray}) {
+                for (std::size_t i = 0; i < arr->size(); ++i) {
+                    std::size_t depth = 0;
+                    for (auto it = (*arr)[i].cbegin(); it != (*arr)[i].cend(); ++it) {
+                        ++depth;
+                    }
+                    hash_detail::add_depth (res, depth);
+                }
+            }
+
+            rehashLog.fill (res);
+            counters.fill (res);
+
+            res.elementsBytes = size() * sizeof(NodeLayout);
+            res.tableBytes = (array.capacity() + oldArray.capacity()) * sizeof(Bucket);
+            res.filterBytes = filter.memory_usage() + oldFilter.memory_usage();
+            return res;
+        }
+
     private:
+        std::size_t buckets_for (std::size_t count) const noexcept {
+            return std::size_t (std::ceil (count / double (maxLoad)));
+        }
+
+        // столько элементов поместится в count корзин до следующего роста
+        std::size_t max_count_for (std::size_t count) const noexcept {
+            return std::size_t (count * double (maxLoad));
+        }
+
         std::size_t buckets_cnt() const noexcept {
             return array.size();
         }
 
-        std::size_t bucket_number (T const& value) const noexcept {
-            return Hash{} (value) % buckets_cnt();
+        std::size_t hash_of (Entry const& entry) const noexcept {
+            if constexpr (Policy::cacheHash) {
+                return entry.hash;
+            } else {
+                return hasher (entry.value);
+            }
         }
 
-        auto begin_end() const noexcept {
-            auto& arr = const_cast<Array&> (array);
-            return algs::make_pair (arr.begin(), arr.end());
+        bool is_migrating() const noexcept {
+            return not oldArray.empty();
+        }
+
+        static
+        auto begin_end (Array const& arr) noexcept {
+            auto& noConstArr = const_cast<Array&> (arr);
+            return algs::make_pair (noConstArr.begin(), noConstArr.end());
         }
 
         auto begin_iter_impl () const noexcept {
-            auto [beg, end] = begin_end();
+            auto [beg, end] = begin_end (array);
+            auto impl = IterImpl {beg, end, elements_iterator{}, end, end};
 
-            beg = algs::find_if (beg, end, [] (auto& bucket) {
-                return not bucket.empty();
-            });
+            if (is_migrating()) {
+                auto [oldBeg, oldEnd] = begin_end (oldArray);
+                impl = IterImpl {oldBeg, oldEnd, elements_iterator{}, beg, end};
+            }
 
-            return IterImpl {
-                beg, end, (beg != end ? beg->prev_begin() : elements_iterator{})
-            };
+            impl.skip_empty();
+            return impl;
         }
 
-        auto find_ (T const& value) const noexcept {
-            auto [bucketIt, endIt] = begin_end();
+        auto end_iter_impl() const noexcept {
+            auto [beg, end] = begin_end (array);
+            return IterImpl {end, end, elements_iterator{}, end, end};
+        }
+
+        template <typename K>
+        void erase_ (K const& key) noexcept {
+            if (is_migrating()) {
+                migrate (migrateStep);
+            }
 
+            if (auto impl = find_ (hasher (key), key); not impl.is_end()) {
+                free_node (*impl.bucketIt, impl.bucketIt->extract_after (impl.prevElemIt));
+                --size_;
+
+                if constexpr (Policy::shrinkRatio > 0) {
+                    shrink_if_sparse();
+                }
+            }
+        }
+
+        // сжатие - лишь экономия памяти: если не хватило памяти на новый
+        // массив, erase всё равно успешен
+        void shrink_if_sparse() noexcept {
+            if (buckets_cnt() <= minBucketCnt)
+                return;
+
+            if (size() >= max_count_for (buckets_cnt()) * Policy::shrinkRatio)
+                return;
+
+            auto newBucketCnt = Index::fit (buckets_for (size() * 2));
+            newBucketCnt = newBucketCnt < minBucketCnt ? Index::fit (minBucketCnt) : newBucketCnt;
+
+            try {
+                if constexpr (Policy::incrementalRehash) {
+                    start_migration (newBucketCnt);
+                } else {
+                    rebuild (newBucketCnt);
+                }
+            } catch (...) {}
+        }
+
+        void reserve_before_insert() {
+            if (is_migrating()) {
+                migrate (migrateStep);
+            }
+
+            if (size() >= buckets_cnt() * double (maxLoad)) {
+                refill();
+            }
+        }
+
+        template <typename K>
+        IterImpl find_ (std::size_t hash, K const& value) const noexcept {
+            auto impl = find_in_buckets (hash, value);
+            counters.lookup (not impl.is_end());
+            return impl;
+        }
+
+        template <typename K>
+        IterImpl find_in_buckets (std::size_t hash, K const& value) const noexcept {
             if (empty())
-                return IterImpl {endIt, endIt, elements_iterator{}};
+                return end_iter_impl();
+
+            // ключи, добавленные до начала переноса, отмечены в старом фильтре
+            if (not filter.may_contain (hash)) {
+                if (not is_migrating() or not oldFilter.may_contain (hash))
+                    return end_iter_impl();
+            }
 
-            bucketIt += bucket_number (value);
-            auto prevElemIt = bucketIt->find_prev_if ([&] (auto& el) {
-                return Eq{} (value, el);
+            auto impl = find_in_array (array, index, hash, value);
+
+            if (impl.is_end() and is_migrating()) {
+                auto [beg, end] = begin_end (array);
+                impl = find_in_array (oldArray, oldIndex, hash, value);
+                impl.nextIt = beg;
+                impl.nextEndIt = end;
+            }
+
+            return impl;
+        }
+
+        template <typename K>
+        IterImpl find_in_array (
+            Array const& arr, Index const& idx, std::size_t hash, K const& value
+        ) const noexcept {
+            auto [bucketIt, endIt] = begin_end (arr);
+
+            bucketIt += idx (hash);
+            auto prevElemIt = bucketIt->find_prev_if ([&] (auto& entry) {
+                counters.probe();
+
+                // сохранённый хеш отсекает почти все несовпадения без вызова Eq
+                if constexpr (Policy::cacheHash) {
+                    if (entry.hash != hash)
+                        return false;
+                }
+                return keyEq (value, entry.value);
             });
 
-            return IterImpl {bucketIt, endIt, prevElemIt};
+            return IterImpl {bucketIt, endIt, prevElemIt, endIt, endIt};
+        }
+
+        template <typename It, typename F>
+        void lookup_batch (It beg, It end, F onFound) const noexcept {
+            std::size_t hashes[hash_detail::lookupBatch];
+
+            while (beg != end) {
+                auto chunkBeg = beg;
+                std::size_t cnt = 0;
+
+                for (; cnt != hash_detail::lookupBatch and beg != end; ++beg, ++cnt) {
+                    hashes[cnt] = hasher (*beg);
+                    if (not empty()) {
+                        prefetch_bucket (hashes[cnt]);
+                    }
+                }
+
+                if (not empty()) {
+                    for (std::size_t i = 0; i != cnt; ++i) {
+                        prefetch_head (array[index (hashes[i])]);
+                    }
+                }
+
+                for (std::size_t i = 0; i != cnt; ++i, ++chunkBeg) {
+                    onFound (find_ (hashes[i], *chunkBeg));
+                }
+            }
+        }
+
+        void prefetch_bucket (std::size_t hash) const noexcept {
+            hash_detail::prefetch (&array[index (hash)]);
+
+            if (is_migrating()) {
+                hash_detail::prefetch (&oldArray[oldIndex (hash)]);
+            }
+        }
+
+        static
+        void prefetch_head (Bucket const& bucket) noexcept {
+            if (not bucket.empty()) {
+                hash_detail::prefetch (&*bucket.begin());
+            }
         }
 
         template <typename T1>
-        void push_to_bucket (T1&& value) {
-            auto bucketIt = array.begin() + bucket_number (value);
-            bucketIt->push_front (std::forward<T1> (value));
+        IterImpl push_to_bucket (std::size_t hash, T1&& value) {
+            auto bucketIt = array.begin() + index (hash);
+
+            emplace_to_bucket (*bucketIt, hash, std::forward<T1> (value));
+            filter.add (hash);
             ++size_;
+
+            auto endIt = array.end();
+            return IterImpl {bucketIt, endIt, bucketIt->prev_begin(), endIt, endIt};
+        }
+
+        // распределители всех корзин равны, годится любая
+        template <typename NodePtr>
+        void free_node (Bucket& bucket, NodePtr node) noexcept {
+            if (arena.owns (node)) {
+                Bucket::destroy_node (node);
+            } else {
+                bucket.delete_node (node);
+            }
+        }
+
+        // узлы из арены нельзя отдавать деструктору FList
+        void release_nodes() noexcept {
+            for (auto arr : {&array, &oldArray}) {
+                for (std::size_t i = 0; i < arr->size(); ++i) {
+                    auto& bucket = (*arr)[i];
+
+                    while (not bucket.empty()) {
+                        free_node (bucket, bucket.extract_after (bucket.prev_begin()));
+                    }
+                }
+            }
+        }
+
+        void clone_buckets (Array& dst, Array const& src, std::size_t& used) {
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                auto pos = dst[i].prev_cbegin();
+
+                for (auto& entry : src[i]) {
+                    auto node = Bucket::construct_node (arena.slot (used), entry);
+                    ++used;
+
+                    dst[i].splice_after (pos, node);
+                    ++pos;
+                }
+            }
+        }
+
+        template <typename T1>
+        static
+        void emplace_to_bucket (Bucket& bucket, std::size_t hash, T1&& value) {
+            if constexpr (Policy::cacheHash) {
+                bucket.emplace_front (std::forward<T1> (value), hash);
+            } else {
+                bucket.emplace_front (std::forward<T1> (value));
+            }
+        }
+
+        // фильтр общий для всех частей, поэтому заполняется уже после потоков;
+        // лишние биты от дубликатов и невставленных элементов безвредны
+        void commit_build (
+            DynamicArray<std::size_t> const& hashes, DynamicArray<std::size_t> const& added
+        ) noexcept {
+            for (std::size_t i = 0; i < hashes.size(); ++i) {
+                filter.add (hashes[i]);
+            }
+            for (std::size_t i = 0; i < added.size(); ++i) {
+                size_ += added[i];
+            }
         }
 
         void refill() {
             if (empty()) {
-                array.resize (minBucketCnt);
+                rebuild (Index::fit (minBucketCnt));
                 return;
             }
-            
-            HashSet newSet;
-            newSet.array.resize (buckets_cnt() * 1.5);
 
-            algs::for_each (begin(), end(), [&] (auto& el) {
-                newSet.push_to_bucket (el);
+            auto newBucketCnt = Index::fit (buckets_cnt() * 1.5);
+
+            if constexpr (Policy::incrementalRehash) {
+                start_migration (newBucketCnt);
+            } else {
+                rebuild (newBucketCnt);
+            }
+        }
+
+        void rebuild (std::size_t newBucketCnt) {
+            auto started = hash_detail::RehashLog::Clock::now();
+            migrate (oldArray.size());
+
+            Array oldBuckets = std::exchange (array, make_buckets (newBucketCnt, get_allocator()));
+            index.reset (newBucketCnt);
+            filter.reset (max_count_for (newBucketCnt));
+
+            algs::for_each (oldBuckets.begin(), oldBuckets.end(), [&] (auto& bucket) {
+                relink_bucket (bucket);
             });
+            rehashLog.add (started);
+        }
+
+        // пустые корзины строятся на месте, каждая со своей копией распределителя;
+        // узлы переходят между корзинами, поэтому копии делят одно состояние
+        static
+        Array make_buckets (std::size_t count, Alloc alloc) {
+            if (count != 0) {
+                alloc_detail::share (alloc);
+            }
+
+            Array buckets (alloc);
+            buckets.reserve (count);
+            for (; count != 0; --count) {
+                buckets.emplace_back (alloc);
+            }
+            return buckets;
+        }
+
+        // переносит узлы корзины в array без копирования элементов и без аллокаций
+        void relink_bucket (Bucket& bucket) noexcept {
+            while (not bucket.empty()) {
+                auto node = bucket.extract_after (bucket.prev_begin());
+                auto hash = hash_of (node->value);
+                auto bucketIt = array.begin() + index (hash);
+
+                filter.add (hash);
+                bucketIt->splice_after (bucketIt->prev_begin(), node);
+            }
+        }
+
+        void start_migration (std::size_t newBucketCnt) {
+            auto started = hash_detail::RehashLog::Clock::now();
+            migrate (oldArray.size());
+
+            Array newArray = make_buckets (newBucketCnt, get_allocator());
+            Filter newFilter;
+            newFilter.reset (max_count_for (newBucketCnt));
+
+            oldFilter = std::move (filter);
+            filter = std::move (newFilter);
+            oldArray = std::move (array);
+            array = std::move (newArray);
+            migrated = 0;
 
-            swap (newSet);
+            oldIndex = index;
+            index.reset (newBucketCnt);
+            rehashLog.add (started);
+        }
+
+        // переносит не больше count корзин из старого массива в новый
+        void migrate (std::size_t count) noexcept {
+            auto bucketsEnd = migrated + count < oldArray.size()
+                            ? migrated + count
+                            : oldArray.size();
+
+            for (; migrated != bucketsEnd; ++migrated) {
+                relink_bucket (oldArray[migrated]);
+            }
+
+            if (migrated == oldArray.size()) {
+                oldArray = Array (oldArray.get_allocator());
+                oldFilter = Filter{};
+                migrated = 0;
+            }
         }
 
         void push_back (T const& value) {
@@ -286,16 +1076,61 @@ namespace data_struct
     private:
         static const std::size_t middleMaxDepth = 5;
         static const std::size_t minBucketCnt = 100;
+        static const std::size_t migrateStep = 4;
+        static const std::size_t minParallelBuild = 1 << 14;
+
+        Hash hasher{};
+        Eq keyEq{};
+        float maxLoad = middleMaxDepth;
+
+        Index index{};
+        Index oldIndex{};
 
         Array array{};
+        Array oldArray{};
+        Filter filter{};
+        Filter oldFilter{};
+        hash_detail::RehashLog rehashLog{};
+        Counters counters{};
+        std::size_t migrated = 0;
         std::size_t size_ = 0;
+
+        // узлы, скопированные конструктором копирования;
+        // распределитель тот же, что у корзин
+        hashset_detail::NodeArena<Bucket::nodeSize, Bucket::nodeAlign, Alloc> arena{};
     };
 
 
-    template <typename T, typename Hash>
-    void swap (HashSet<T, Hash>& lhs, HashSet<T, Hash>& rhs) noexcept {
+    template <typename T, typename Hash, typename Eq, typename Policy, typename Alloc>
+    void swap (HashSet<T, Hash, Eq, Policy, Alloc>& lhs, HashSet<T, Hash, Eq, Policy, Alloc>& rhs) noexcept {
         lhs.swap (rhs);
     }
+
+
+    // HashSet с OpenAddressing - это FlatHashSet
+    template <typename T, typename Hash, typename Eq, typename Policy, typename Alloc>
+    class HashSet<T, Hash, Eq, Policy, Alloc, OpenAddressing>
+        : public FlatHashSet<T, Hash, Eq, Policy, Alloc>
+    {
+        using Base = FlatHashSet<T, Hash, Eq, Policy, Alloc>;
+
+    public:
+        using Base::Base;
+
+        HashSet() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+    };
+
+
+    namespace pmr
+    {
+        template <
+            typename T
+          , typename Hash = Hasher<T>
+          , typename Eq = DefaultEqual<T>
+          , typename Policy = DefaultHashPolicy
+        >
+        using HashSet = data_struct::HashSet<T, Hash, Eq, Policy, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 
 #endif
\ No newline at end of file
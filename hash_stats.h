@@ -0,0 +1,122 @@
+#ifndef MY_HASH_STATS_H_GUARD
+#define MY_HASH_STATS_H_GUARD
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+#include "dynamic_array.h"
+
+namespace data_struct
+{
+    // снимок состояния хеш-множества, собирается stats() за O(size + buckets)
+    struct HashStats {
+        std::size_t size = 0;
+        std::size_t bucketCount = 0;
+        float loadFactor = 0;
+
+        // depthHistogram[d] - для HashSet число корзин из d элементов,
+        // для FlatHashSet число элементов в d группах от своей начальной
+        DynamicArray<std::size_t> depthHistogram{};
+        std::size_t maxDepth = 0;
+
+        std::size_t rehashCount = 0;
+        double rehashSeconds = 0;
+
+        std::size_t elementsBytes = 0;  // узлы списков или ячейки
+        std::size_t tableBytes = 0;     // массив корзин или управляющие байты
+        std::size_t filterBytes = 0;
+
+        // только при Policy::countOps, иначе нули;
+        // probes - сколько элементов сравнено с ключом
+        std::size_t lookups = 0;
+        std::size_t hits = 0;
+        std::size_t probes = 0;
+    };
+}
+
+
+namespace hash_detail
+{
+    // перестроения за всё время жизни; шаги постепенного переноса не входят
+    struct RehashLog {
+        using Clock = std::chrono::steady_clock;
+
+        void add (Clock::time_point started) noexcept {
+            ++count;
+            seconds += std::chrono::duration<double> (Clock::now() - started).count();
+        }
+
+        void fill (data_struct::HashStats& stats) const noexcept {
+            stats.rehashCount = count;
+            stats.rehashSeconds = seconds;
+        }
+
+        std::size_t count = 0;
+        double seconds = 0;
+    };
+
+
+    // счётчики меняются из const-поиска, в том числе параллельного
+    // под shared_lock, поэтому атомарные (relaxed)
+    struct OpCounters {
+        OpCounters() noexcept = default;
+
+        OpCounters (OpCounters const& rhs) noexcept
+            : lookups (rhs.lookups.load (std::memory_order_relaxed))
+            , hits (rhs.hits.load (std::memory_order_relaxed))
+            , probes (rhs.probes.load (std::memory_order_relaxed))
+        {}
+
+        OpCounters& operator= (OpCounters const& rhs) noexcept {
+            lookups.store (rhs.lookups.load (std::memory_order_relaxed), std::memory_order_relaxed);
+            hits.store (rhs.hits.load (std::memory_order_relaxed), std::memory_order_relaxed);
+            probes.store (rhs.probes.load (std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+
+        void lookup (bool hit) const noexcept {
+            lookups.fetch_add (1, std::memory_order_relaxed);
+            hits.fetch_add (hit, std::memory_order_relaxed);
+        }
+
+        void probe() const noexcept {
+            probes.fetch_add (1, std::memory_order_relaxed);
+        }
+
+        void fill (data_struct::HashStats& stats) const noexcept {
+            stats.lookups = lookups.load (std::memory_order_relaxed);
+            stats.hits = hits.load (std::memory_order_relaxed);
+            stats.probes = probes.load (std::memory_order_relaxed);
+        }
+
+        mutable std::atomic<std::size_t> lookups {0};
+        mutable std::atomic<std::size_t> hits {0};
+        mutable std::atomic<std::size_t> probes {0};
+    };
+
+
+    struct NoOpCounters {
+        void lookup (bool) const noexcept {}
+        void probe() const noexcept {}
+        void fill (data_struct::HashStats&) const noexcept {}
+    };
+
+
+    template <typename Policy>
+    using CountersFor = std::conditional_t<Policy::countOps, OpCounters, NoOpCounters>;
+
+
+    inline void add_depth (data_struct::HashStats& stats, std::size_t depth) {
+        while (stats.depthHistogram.size() <= depth) {
+            stats.depthHistogram.push_back (0);
+        }
+        ++stats.depthHistogram[depth];
+
+        if (depth > stats.maxDepth) {
+            stats.maxDepth = depth;
+        }
+    }
+}
+
+#endif
@@ -3,41 +3,77 @@
 
 #include <stdexcept>
 #include "hash_set.h"
+#include "flat_hash_set.h"
 
 namespace data_struct
 {
+    // обе функции прозрачны: искать можно по самому ключу
+    // или по любому типу, который принимает Hasher<Key> и сравнивается с Key
     template <typename Key, typename Value>
     struct KeyValueHash {
-        size_t operator() (Pair<Key, Value> const& kv) const {
-            return Hasher<Key>{} (kv.first);
+        using is_transparent = void;
+
+        KeyValueHash() = default;
+
+        explicit constexpr KeyValueHash (Hasher<Key> const& hash)
+            : hasher (hash)
+        {}
+
+        constexpr size_t operator() (Pair<Key, Value> const& kv) const {
+            return hasher (kv.first);
         }
+
+        template <typename K>
+        constexpr size_t operator() (K const& key) const {
+            return hasher (key);
+        }
+
+        Hasher<Key> hasher{};
     };
 
     template <typename Key, typename Value>
     struct KeyValueEqual {
-        bool operator() (Pair<Key, Value> const& kv, Pair<Key, Value> const& kv2) const {
+        using is_transparent = void;
+
+        constexpr bool operator() (Pair<Key, Value> const& kv, Pair<Key, Value> const& kv2) const {
             return kv.first == kv2.first;
         }
+
+        template <typename K>
+        constexpr bool operator() (K const& key, Pair<Key, Value> const& kv) const {
+            return kv.first == key;
+        }
     };
 
 
+    template <typename T, typename Hash, typename Eq, typename Policy, typename Alloc = std::allocator<T>>
+    using HashSetFor = std::conditional_t<
+        std::is_same_v<typename Policy::Layout, OpenAddressing>
+      , FlatHashSet<T, Hash, Eq, Policy, Alloc>
+      , HashSet<T, Hash, Eq, Policy, Alloc>
+    >;
+
+
     template <
         typename Key
       , typename Value
       , typename Hash = KeyValueHash<Key, Value>
       , typename Eq = KeyValueEqual<Key, Value>
+      , typename Policy = DefaultHashPolicy
+      , typename Alloc = std::allocator<Pair<Key, Value>>
     >
     class HashTable {
         using Elem = Pair<Key, Value>;
-        using Impl = HashSet<Elem, Hash, Eq>;
+        using Impl = HashSetFor<Elem, Hash, Eq, Policy, Alloc>;
         using Self = HashTable;
 
     public:
-        using iterator       = typename Impl::iterator;
+        using iterator       = KeyValueIterator<typename Impl::iterator, typename Impl::const_iterator>;
         using const_iterator = typename Impl::const_iterator;
+        using allocator_type = Alloc;
 
     public:
-        HashTable() noexcept = default;
+        HashTable() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
         ~HashTable() noexcept = default;
 
         HashTable(Self const&) = default;
@@ -46,10 +82,27 @@ namespace data_struct
         Self& operator= (Self const&) = default;
         Self& operator= (Self&&) noexcept = default;
 
-        HashTable (std::initializer_list<Elem> iList)
-            : impl (iList)
+        HashTable (std::initializer_list<Elem> iList, Alloc const& alloc = Alloc{})
+            : impl (iList, alloc)
+        {}
+
+        template <class Iter, class = EnableIfForward<Iter>>
+        HashTable (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : impl (beg, end, alloc)
+        {}
+
+        explicit HashTable (Alloc const& alloc)
+            : impl (alloc)
         {}
 
+        explicit HashTable (Hash const& hash, Eq const& eq = Eq{}, Alloc const& alloc = Alloc{})
+            : impl (hash, eq, alloc)
+        {}
+
+        allocator_type get_allocator() const noexcept {
+            return impl.get_allocator();
+        }
+
         void swap (HashTable& rhs) noexcept {
             impl.swap(rhs.impl);
         }
@@ -62,6 +115,55 @@ namespace data_struct
             return impl.size();
         }
 
+        // ключи [beg, end) ищутся пачками с предвыборкой памяти,
+        // для каждого в out пишется итератор (end(), если ключа нет)
+        template <typename It, typename OutIt>
+        OutIt find_batch (It beg, It end, OutIt out) {
+            return impl.find_batch (beg, end, out);
+        }
+
+        template <typename It, typename OutIt>
+        OutIt find_batch (It beg, It end, OutIt out) const {
+            return impl.find_batch (beg, end, out);
+        }
+
+        template <typename It, typename OutIt>
+        OutIt contains_batch (It beg, It end, OutIt out) const {
+            return impl.contains_batch (beg, end, out);
+        }
+
+        std::size_t bucket_count() const noexcept {
+            return impl.bucket_count();
+        }
+
+        float load_factor() const noexcept {
+            return impl.load_factor();
+        }
+
+        float max_load_factor() const noexcept {
+            return impl.max_load_factor();
+        }
+
+        void max_load_factor (float factor) {
+            impl.max_load_factor (factor);
+        }
+
+        void rehash (std::size_t count) {
+            impl.rehash (count);
+        }
+
+        void reserve (std::size_t count) {
+            impl.reserve (count);
+        }
+
+        void shrink_to_fit() {
+            impl.shrink_to_fit();
+        }
+
+        HashStats stats() const {
+            return impl.stats();
+        }
+
         auto cbegin() const noexcept {
             return impl.cbegin();
         }
@@ -78,31 +180,96 @@ namespace data_struct
             return cend();
         }
 
-        void add (Key const& key, Value const& value = Value{}) {
-            Elem el {key, value};
-            impl.add (el);
+        Pair<iterator, bool> add (Key const& key, Value const& value = Value{}) {
+            return try_emplace (key, value);
         }
 
-        void erase (Key const& key) {
-            impl.erase (
-                Elem {key, Value{}}
-            );
+        template <typename... Ts>
+        Pair<iterator, bool> emplace (Ts&&... params) {
+            auto res = impl.emplace (std::forward<Ts> (params)...);
+            return {res.first, res.second};
+        }
+
+        // значение строится только если ключа ещё нет
+        template <typename... Ts>
+        Pair<iterator, bool> try_emplace (Key const& key, Ts&&... params) {
+            auto res = impl.lazy_emplace (key, [&] {
+                return Elem {key, Value {std::forward<Ts> (params)...}};
+            });
+            return {res.first, res.second};
+        }
+
+        template <typename... Ts>
+        Pair<iterator, bool> try_emplace (Key&& key, Ts&&... params) {
+            auto res = impl.lazy_emplace (key, [&] {
+                return Elem {std::move (key), Value {std::forward<Ts> (params)...}};
+            });
+            return {res.first, res.second};
+        }
+
+        template <typename V>
+        Pair<iterator, bool> insert_or_assign (Key const& key, V&& value) {
+            auto res = impl.lazy_emplace (key, [&] {
+                return Elem {key, Value {std::forward<V> (value)}};
+            });
+
+            if (not res.second) {
+                res.first->second = std::forward<V> (value);
+            }
+            return {res.first, res.second};
+        }
+
+        template <typename V>
+        Pair<iterator, bool> insert_or_assign (Key&& key, V&& value) {
+            auto res = impl.lazy_emplace (key, [&] {
+                return Elem {std::move (key), Value {std::forward<V> (value)}};
+            });
+
+            if (not res.second) {
+                res.first->second = std::forward<V> (value);
+            }
+            return {res.first, res.second};
+        }
+
+        template <class Iter, class = EnableIfForward<Iter>>
+        void insert (Iter beg, Iter end) {
+            impl.insert (beg, end);
+        }
+
+        // диапазон пар с произвольным доступом, заполняется в threads потоков
+        template <typename RandomIt>
+        void build (RandomIt beg, RandomIt end, std::size_t threads = std::thread::hardware_concurrency()) {
+            impl.build (beg, end, threads);
+        }
+
+        template <typename K = Key>
+        void erase (K const& key) {
+            impl.erase (key);
         }
 
-        Value& operator[] (Key const& key) {
+        template <typename K = Key>
+        Value& operator[] (K const& key) {
             return get (key);
         }
 
-        Value const& operator[] (Key const& key) const {
+        template <typename K = Key>
+        Value const& operator[] (K const& key) const {
             return get (key);
         }
 
-        const_iterator find (Key const& key) const {
-            return impl.find (Elem {key, Value{}});
+        template <typename K = Key>
+        iterator find (K const& key) {
+            return impl.find (key);
+        }
+
+        template <typename K = Key>
+        const_iterator find (K const& key) const {
+            return impl.find (key);
         }
 
     private:
-        Value& get (Key const& key) const {
+        template <typename K>
+        Value& get (K const& key) const {
             auto it = find (key);
 
             if (it == end()) throw std::runtime_error (
@@ -117,10 +284,28 @@ namespace data_struct
     };
 
 
-    template <typename Key, typename Value, typename Hash>
-    void swap (HashTable<Key, Value, Hash>& lhs, HashTable<Key, Value, Hash>& rhs) noexcept {
+    template <typename Key, typename Value, typename Hash, typename Eq, typename Policy, typename Alloc>
+    void swap (
+        HashTable<Key, Value, Hash, Eq, Policy, Alloc>& lhs
+      , HashTable<Key, Value, Hash, Eq, Policy, Alloc>& rhs
+    ) noexcept {
         lhs.swap (rhs);
     }
+
+
+    namespace pmr
+    {
+        template <
+            typename Key
+          , typename Value
+          , typename Hash = KeyValueHash<Key, Value>
+          , typename Eq = KeyValueEqual<Key, Value>
+          , typename Policy = DefaultHashPolicy
+        >
+        using HashTable = data_struct::HashTable<
+            Key, Value, Hash, Eq, Policy, std::pmr::polymorphic_allocator<Pair<Key, Value>>
+        >;
+    }
 }
 
 #endif
\ No newline at end of file
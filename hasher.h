@@ -0,0 +1,234 @@
+#ifndef MY_HASHER_H_GUARD
+#define MY_HASHER_H_GUARD
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include "iterators.h"
+#include "my_algorithm.h"
+#include "hash_general.h"
+
+
+namespace hash_detail
+{
+    using u64 = std::uint64_t;
+
+    constexpr u64 secret[4] = {
+        0xa0761d6478bd642full, 0xe7037ed1a0b428dbull
+      , 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+    };
+
+
+    // 64x64 -> 128 бит, a получает младшую половину, b - старшую
+    constexpr void mum (u64& a, u64& b) noexcept {
+    #if defined(__SIZEOF_INT128__)
+        __uint128_t r = a;
+        r *= b;
+        a = static_cast<u64> (r);
+        b = static_cast<u64> (r >> 64);
+    #else
+        u64 ha = a >> 32, hb = b >> 32, la = std::uint32_t (a), lb = std::uint32_t (b);
+        u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        u64 t = rl + (rm0 << 32);
+        u64 c = t < rl;
+        u64 lo = t + (rm1 << 32);
+        c += lo < t;
+        a = lo;
+        b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    #endif
+    }
+
+
+    constexpr u64 mix (u64 a, u64 b) noexcept {
+        mum (a, b);
+        return a ^ b;
+    }
+
+
+    // побайтовое чтение остаётся constexpr, компилятор сводит его к одной загрузке
+    constexpr u64 read64 (char const* p) noexcept {
+        u64 res = 0;
+        for (int i = 7; i >= 0; --i) {
+            res = (res << 8) | static_cast<unsigned char> (p[i]);
+        }
+        return res;
+    }
+
+
+    constexpr u64 read32 (char const* p) noexcept {
+        u64 res = 0;
+        for (int i = 3; i >= 0; --i) {
+            res = (res << 8) | static_cast<unsigned char> (p[i]);
+        }
+        return res;
+    }
+
+
+    constexpr u64 read_small (char const* p, std::size_t len) noexcept {
+        return (u64 (static_cast<unsigned char> (p[0])) << 16)
+             | (u64 (static_cast<unsigned char> (p[len >> 1])) << 8)
+             | u64 (static_cast<unsigned char> (p[len - 1]));
+    }
+
+
+    // wyhash (final 4)
+    constexpr u64 hash_bytes (char const* p, std::size_t len, u64 seed) noexcept {
+        seed ^= mix (seed ^ secret[0], secret[1]);
+        u64 a = 0, b = 0;
+
+        if (len <= 16) {
+            if (len >= 4) {
+                auto shift = (len >> 3) << 2;
+                a = (read32 (p) << 32) | read32 (p + shift);
+                b = (read32 (p + len - 4) << 32) | read32 (p + len - 4 - shift);
+            } else if (len > 0) {
+                a = read_small (p, len);
+            }
+        } else {
+            auto rest = len;
+
+            if (rest > 48) {
+                auto seed1 = seed, seed2 = seed;
+                do {
+                    seed  = mix (read64 (p) ^ secret[1], read64 (p + 8) ^ seed);
+                    seed1 = mix (read64 (p + 16) ^ secret[2], read64 (p + 24) ^ seed1);
+                    seed2 = mix (read64 (p + 32) ^ secret[3], read64 (p + 40) ^ seed2);
+                    p += 48;
+                    rest -= 48;
+                } while (rest > 48);
+                seed ^= seed1 ^ seed2;
+            }
+
+            while (rest > 16) {
+                seed = mix (read64 (p) ^ secret[1], read64 (p + 8) ^ seed);
+                p += 16;
+                rest -= 16;
+            }
+
+            a = read64 (p + rest - 16);
+            b = read64 (p + rest - 8);
+        }
+
+        a ^= secret[1];
+        b ^= seed;
+        mum (a, b);
+
+        return mix (a ^ secret[0] ^ len, b ^ secret[1]);
+    }
+
+
+    constexpr u64 hash_int (u64 value, u64 seed) noexcept {
+        return mix (value ^ secret[0], seed ^ secret[1]);
+    }
+
+
+    constexpr u64 combine (u64 lhs, u64 rhs) noexcept {
+        return mix (lhs ^ secret[2], rhs ^ secret[3]);
+    }
+
+
+    struct SeededHasher {
+        constexpr SeededHasher() noexcept = default;
+
+        explicit constexpr SeededHasher (u64 seed_) noexcept
+            : seed (seed_)
+        {}
+
+        u64 seed = 0;
+    };
+
+
+    template <typename T>
+    using EnableIfInteger = std::enable_if_t<
+        std::is_integral_v<T> or std::is_enum_v<T>
+    >;
+}
+
+
+namespace data_struct
+{
+    template <typename T>
+    struct Hasher<T, hash_detail::EnableIfInteger<T>> : hash_detail::SeededHasher {
+        using SeededHasher::SeededHasher;
+
+        constexpr std::size_t operator() (T value) const noexcept {
+            return hash_detail::hash_int (static_cast<hash_detail::u64> (value), seed);
+        }
+    };
+
+
+    template <typename T>
+    struct Hasher<T*> : hash_detail::SeededHasher {
+        using SeededHasher::SeededHasher;
+
+        std::size_t operator() (T const* ptr) const noexcept {
+            return hash_detail::hash_int (reinterpret_cast<std::uintptr_t> (ptr), seed);
+        }
+    };
+
+
+    template <typename T>
+    struct Hasher<T, std::enable_if_t<std::is_floating_point_v<T>>> : hash_detail::SeededHasher {
+        using SeededHasher::SeededHasher;
+
+        std::size_t operator() (T value) const noexcept {
+            if (value == T{}) {
+                value = T{};    // +0.0 и -0.0 равны, значит и хеш у них общий
+            }
+
+            char bytes[sizeof(T)];
+            std::memcpy (bytes, &value, sizeof(T));
+            return hash_detail::hash_bytes (bytes, sizeof(T), seed);
+        }
+    };
+
+
+    template <>
+    struct Hasher<std::string_view> : hash_detail::SeededHasher {
+        using SeededHasher::SeededHasher;
+        using is_transparent = void;
+
+        constexpr std::size_t operator() (std::string_view str) const noexcept {
+            return hash_detail::hash_bytes (str.data(), str.size(), seed);
+        }
+    };
+
+
+    // принимает std::string_view и const char* без создания std::string
+    template <>
+    struct Hasher<std::string> : Hasher<std::string_view> {
+        using Hasher<std::string_view>::Hasher;
+    };
+
+
+    template <typename T, typename U>
+    struct Hasher<Pair<T, U>> : hash_detail::SeededHasher {
+        using SeededHasher::SeededHasher;
+
+        std::size_t operator() (Pair<T, U> const& pair) const {
+            return hash_detail::combine (
+                Hasher<T> {seed} (pair.first)
+              , Hasher<U> {seed} (pair.second)
+            );
+        }
+    };
+
+
+    template <typename... Ts>
+    struct Hasher<std::tuple<Ts...>> : hash_detail::SeededHasher {
+        using SeededHasher::SeededHasher;
+
+        std::size_t operator() (std::tuple<Ts...> const& tuple) const {
+            return std::apply ([&] (auto const&... elems) {
+                hash_detail::u64 res = seed;
+                ((res = hash_detail::combine (res, Hasher<std::decay_t<decltype (elems)>> {seed} (elems))), ...);
+                return static_cast<std::size_t> (res);
+            }, tuple);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef KEY_VALUE_ITERATOR_TEMPLATE_H_GUARD
+#define KEY_VALUE_ITERATOR_TEMPLATE_H_GUARD
+
+#include "iterators_general.h"
+
+namespace data_struct
+{
+    // ссылка на элемент таблицы: ключ только для чтения, значение изменяемо
+    template <typename Key, typename Value>
+    struct KeyValueRef {
+        Key const& first;
+        Value& second;
+
+        KeyValueRef* operator->() noexcept {
+            return this;
+        }
+    };
+
+
+    // изменяемый итератор таблицы поверх итератора множества пар:
+    // запись в ключ переставила бы элемент не в свою корзину.
+    // Приводится к ConstIter, поэтому сравнивается с end()
+    template <typename Iter, typename ConstIter>
+    class KeyValueIterator
+    {
+        using Self = KeyValueIterator;
+        using Elem = typename Iter::value_type;
+        using Key = decltype (std::declval<Elem&>().first);
+        using Value = decltype (std::declval<Elem&>().second);
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+
+        using value_type = Elem;
+        using reference  = KeyValueRef<Key, Value>;
+        using pointer    = KeyValueRef<Key, Value>;
+
+    public:
+        KeyValueIterator() = default;
+
+        KeyValueIterator (Iter iter_)
+            : iter (iter_)
+        {}
+
+        operator ConstIter() const {
+            return iter;
+        }
+
+        friend
+        bool operator== (Self const& lhs, Self const& rhs) {
+            return lhs.iter == rhs.iter;
+        }
+
+        friend
+        bool operator!= (Self const& lhs, Self const& rhs) {
+            return not (lhs == rhs);
+        }
+
+        reference operator*() const {
+            return reference {iter->first, iter->second};
+        }
+
+        pointer operator->() const {
+            return operator*();
+        }
+
+        Self& operator++() {
+            ++iter;
+            return *this;
+        }
+
+        Self operator++ (int i) {
+            auto tmp = *this;
+            ++iter;
+            return tmp;
+        }
+
+    private:
+        Iter iter{};
+    };
+}
+
+#endif
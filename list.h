@@ -1,13 +1,41 @@
 #ifndef MY_LIST_GUARD_H
 #define MY_LIST_GUARD_H
 
+#include <memory>
 #include <utility>
+#include "allocator.h"
 #include "iterators.h"
 #include "my_algorithm.h"
+#include "node_pool.h"
 
 
 namespace list_detail
 {
+    struct Head {
+        void bind() noexcept {
+            next->prev = prev->next = this;
+        }
+
+        void rebind() noexcept {
+            prev->next = next;
+            next->prev = prev;
+        }
+
+        void reset() noexcept {
+            prev = next = this;
+        }
+
+        Head* prev = this;
+        Head* next = this;
+    };
+
+
+    template <typename T>
+    struct Node: public Head {
+        T value;
+    };
+
+
     template <typename T, typename C>
     struct IterImpl {
         using Container = C;
@@ -61,29 +89,12 @@ namespace list_detail
 
 namespace data_struct
 {
-    template <typename T>
-    class List {
-        struct Head {
-            void bind() noexcept {
-                next->prev = prev->next = this;
-            }
-
-            void rebind() noexcept {
-                prev->next = next;
-                next->prev = prev;
-            }
-
-            void reset() noexcept {
-                prev = next = this;
-            }
-
-            Head* prev = this;
-            Head* next = this;
-        };
-
-        struct Node: public Head {
-            T value;
-        };
+    // узлы берутся у Alloc, пересвязанного на тип узла
+    template <typename T, typename Alloc = std::allocator<T>>
+    class List : private alloc_detail::Rebind<Alloc, list_detail::Node<T>> {
+        using Head = list_detail::Head;
+        using Node = list_detail::Node<T>;
+        using NodeAlloc = alloc_detail::Rebind<Alloc, Node>;
 
         using IterImpl = list_detail::IterImpl<T, List>;
         friend IterImpl;
@@ -91,49 +102,74 @@ namespace data_struct
     public:
         using iterator       = BidirectionalIterator<T, IterImpl, Mutable_tag>;
         using const_iterator = BidirectionalIterator<T, IterImpl, Const_tag>;
+        using allocator_type = Alloc;
     
     public:
-        List() noexcept = default;
+        List() noexcept (std::is_nothrow_default_constructible_v<NodeAlloc>) = default;
+
+        explicit List (Alloc const& alloc) noexcept
+            : NodeAlloc (alloc)
+        {}
 
         List (List&& rhs) noexcept
-          : size_ (rhs.size_)
+          : NodeAlloc (std::move (rhs.node_alloc()))
           , endHead (rhs.endHead)
+          , size_ (rhs.size_)
         {
             set_end_head (rhs.empty(), endHead);
             rhs.size_ = 0;
             rhs.endHead.reset();
         }
 
-        List (List const& rhs) {
-            algs::copy (rhs.begin(), rhs.end(), algs::back_inserter (*this));
-        }
+        List (List const& rhs)
+            : List (rhs, alloc_detail::select_for_copy (rhs.get_allocator()))
+        {}
+
+        List (List const& rhs, Alloc const& alloc)
+            : List (rhs.begin(), rhs.end(), alloc)
+        {}
 
         template <class Iter, class = EnableIfForward<Iter>>
-        List (Iter beg, Iter end) {
+        List (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : List (alloc)
+        {
             algs::copy (beg, end, algs::back_inserter (*this));
         }
 
-        List (std::initializer_list<T> iList) {
-            algs::copy (iList.begin(), iList.end(), algs::back_inserter (*this));
-        }
+        List (std::initializer_list<T> iList, Alloc const& alloc = Alloc{})
+            : List (iList.begin(), iList.end(), alloc)
+        {}
 
-        List (std::size_t count, T const& value = T()) {
+        List (std::size_t count, T const& value = T(), Alloc const& alloc = Alloc{})
+            : List (alloc)
+        {
             while (count--) {
                 push_back (value);
             }
         }
 
-        List& operator= (List&& rhs) noexcept {
-            if (this != &rhs) {
+        // узлы забираются, только если их можно вернуть через свой
+        // распределитель, иначе значения переносятся по одному
+        List& operator= (List&& rhs) noexcept (std::allocator_traits<NodeAlloc>::is_always_equal::value) {
+            if (this == &rhs)
+                return *this;
+
+            if (alloc_detail::can_take_storage (node_alloc(), rhs.node_alloc())) {
                 auto tmp {std::move (rhs)};
                 swap (tmp);
+            } else {
+                List tmp (get_allocator());
+                for (auto& el : rhs) {
+                    tmp.push_back (std::move (el));
+                }
+                swap (tmp);
             }
             return *this;
         }
 
         List& operator= (List const& rhs) {
             if (this != &rhs) {
-                auto tmp {rhs};
+                List tmp {rhs, alloc_detail::for_copy_assign (get_allocator(), rhs.get_allocator())};
                 swap (tmp);
             }
             return *this;
@@ -152,6 +188,7 @@ namespace data_struct
         }
 
         void swap (List& rhs) noexcept {
+            alloc_detail::swap (node_alloc(), rhs.node_alloc());
             std::swap (size_, rhs.size_);
             std::swap (endHead, rhs.endHead);
 
@@ -159,6 +196,10 @@ namespace data_struct
             set_end_head (rhs.empty(), rhs.endHead);
         }
 
+        allocator_type get_allocator() const noexcept {
+            return Alloc (node_alloc());
+        }
+
         iterator begin() noexcept {
             return iterator {endHead.next};
         }
@@ -202,10 +243,11 @@ namespace data_struct
         template <typename... Ts>
         iterator emplace (const_iterator it, Ts&&... params) {
             auto pHead = it.real();
-            auto newNode = new Node {
-                Head {pHead->prev, pHead}
+            auto newNode = alloc_detail::new_object (
+                node_alloc()
+              , Head {pHead->prev, pHead}
               , std::forward<Ts> (params)...
-            };
+            );
             newNode->bind();
             ++size_;
 
@@ -252,7 +294,7 @@ namespace data_struct
 
             --size_;
             pHead->rebind();
-            delete (get_ptr_node (pHead));
+            alloc_detail::delete_object (node_alloc(), get_ptr_node (pHead));
 
             return iterator {pNext};
         }
@@ -269,11 +311,24 @@ namespace data_struct
             erase (begin());
         }
 
+        // узлы возвращаются распределителю; пул оставляет их себе
+        void clear() noexcept {
+            erase (begin(), end());
+        }
+
         void pop_back() noexcept {
             erase (--end());
         }
 
     private:
+        NodeAlloc& node_alloc() noexcept {
+            return *this;
+        }
+
+        NodeAlloc const& node_alloc() const noexcept {
+            return *this;
+        }
+
         static
         void set_end_head (bool cond, Head& head) noexcept {
             (cond ? head.reset() : head.bind());
@@ -295,11 +350,23 @@ namespace data_struct
     };
 
 
-    template <typename T>
-    void swap (List<T>& lhs, List<T>& rhs)
+    template <typename T, typename Alloc>
+    void swap (List<T, Alloc>& lhs, List<T, Alloc>& rhs)
     {
         lhs.swap(rhs);
     }
+
+
+    // узлы из слябов, без аллокации на каждую вставку
+    template <typename T>
+    using PooledList = List<T, NodePoolAllocator<T>>;
+
+
+    namespace pmr
+    {
+        template <typename T>
+        using List = data_struct::List<T, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 
 #endif
\ No newline at end of file
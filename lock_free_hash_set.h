@@ -0,0 +1,504 @@
+#ifndef MY_LOCK_FREE_HASH_SET_H_GUARD
+#define MY_LOCK_FREE_HASH_SET_H_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include "dynamic_array.h"
+#include "my_algorithm.h"
+#include "hash_general.h"
+#include "hasher.h"
+
+namespace lockfree_detail
+{
+    // младший бит next - пометка "узел логически удалён" (Harris-Michael)
+    using Word = std::uintptr_t;
+
+
+    // узел, как в FList, только next атомарный; soKey - позиция в общем
+    // упорядоченном списке: чётный у стражей корзин, нечётный у элементов
+    struct Head {
+        std::atomic<Word> next {0};
+        std::size_t soKey = 0;
+    };
+
+
+    template <typename T>
+    struct Node : Head {
+        template <typename... Ts>
+        explicit Node (std::size_t key, Ts&&... params)
+            : value (std::forward<Ts> (params)...)
+        {
+            soKey = key;
+        }
+
+        T value;
+    };
+
+
+    inline Head* ptr (Word word) noexcept {
+        return reinterpret_cast<Head*> (word & ~Word (1));
+    }
+
+
+    inline Word word (Head* head) noexcept {
+        return reinterpret_cast<Word> (head);
+    }
+
+
+    inline bool is_marked (Word word) noexcept {
+        return word & 1;
+    }
+
+
+    inline std::uint64_t reverse_bits (std::uint64_t x) noexcept {
+        x = ((x >> 1)  & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+        x = ((x >> 2)  & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+        x = ((x >> 4)  & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+        x = ((x >> 8)  & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+        x = ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+        return (x >> 32) | (x << 32);
+    }
+
+
+    inline unsigned highest_bit (std::uint64_t x) noexcept {
+        unsigned res = 0;
+        while (x >>= 1) {
+            ++res;
+        }
+        return res;
+    }
+
+
+    // запись о потоке для эпохальной очистки памяти: пока поток внутри
+    // операции, в local лежит (эпоха << 1) | 1, иначе 0
+    struct Record {
+        std::atomic<std::uint64_t> local {0};
+        std::atomic<bool> inUse {false};
+        Record* next = nullptr;
+        data_struct::DynamicArray<data_struct::Pair<Head*, std::uint64_t>> retired;
+    };
+}
+
+
+namespace data_struct
+{
+    // хеш-множество без блокировок на split-ordered list (Shalev, Shavit):
+    // все элементы лежат в одном списке, упорядоченном по перевёрнутому хешу,
+    // корзина - указатель на стража внутри списка. При росте число корзин
+    // удваивается, а новые стражи вставляются лениво при первом обращении,
+    // поэтому элементы никогда не переносятся.
+    // Удалённые узлы освобождаются после того, как все потоки,
+    // которые могли их видеть, вышли из своих операций (epoch-based reclamation)
+    template <typename T, typename Hash = Hasher<T>, typename Eq = DefaultEqual<T>>
+    class LockFreeHashSet {
+        using Head = lockfree_detail::Head;
+        using Node = lockfree_detail::Node<T>;
+        using Record = lockfree_detail::Record;
+        using Word = lockfree_detail::Word;
+        using Bucket = std::atomic<Head*>;
+
+        template <typename K>
+        using EnableIfTransparent = std::enable_if_t<
+            hash_detail::IsTransparent<Hash, K>::value and hash_detail::IsTransparent<Eq, K>::value
+        >;
+
+        // текущий поток внутри операции: освобождать то, что он видит, нельзя
+        class Guard {
+        public:
+            explicit Guard (LockFreeHashSet const& set_)
+                : set (set_)
+                , rec (set_.acquire_record())
+            {
+                rec->local.store ((set.epoch.load() << 1) | 1);
+            }
+
+            ~Guard() noexcept {
+                rec->local.store (0);
+                rec->inUse.store (false);
+            }
+
+            Guard (Guard const&) = delete;
+            Guard& operator= (Guard const&) = delete;
+
+            void retire (Head* head) {
+                set.retire (*rec, head);
+            }
+
+        private:
+            LockFreeHashSet const& set;
+            Record* rec;
+        };
+
+    public:
+        explicit LockFreeHashSet (Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : hasher (hash)
+            , keyEq (eq)
+        {
+            bucket (0).store (new Head);
+        }
+
+        LockFreeHashSet (LockFreeHashSet const&) = delete;
+        LockFreeHashSet& operator= (LockFreeHashSet const&) = delete;
+
+        // вызывать только когда других потоков уже нет
+        ~LockFreeHashSet() noexcept {
+            for (auto head = bucket (0).load(); head;) {
+                auto next = lockfree_detail::ptr (head->next.load());
+                destroy (head);
+                head = next;
+            }
+
+            for (auto rec = records.load(); rec;) {
+                auto next = rec->next;
+                for (std::size_t i = 0; i < rec->retired.size(); ++i) {
+                    destroy (rec->retired[i].first);
+                }
+                delete rec;
+                rec = next;
+            }
+
+            for (auto& segment : segments) {
+                delete[] segment.load();
+            }
+        }
+
+    public:
+        // при параллельных изменениях - лишь оценка
+        std::size_t size() const noexcept {
+            return size_.load();
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        template <class T1, class = std::enable_if_t<std::is_same_v<std::decay_t<T1>, T>>>
+        bool add (T1&& value) {
+            return emplace (std::forward<T1> (value));
+        }
+
+        // true, если элемента не было и он добавлен
+        template <typename... Ts>
+        bool emplace (Ts&&... params) {
+            auto node = new Node (0, std::forward<Ts> (params)...);
+            auto hash = hasher (node->value);
+            node->soKey = regular_key (hash);
+
+            Guard guard {*this};
+            auto start = bucket_head (hash, guard);
+
+            for (;;) {
+                Head* prev;
+                Head* cur;
+
+                if (search (start, node->soKey, &node->value, prev, cur, guard)) {
+                    delete node;
+                    return false;
+                }
+
+                node->next.store (lockfree_detail::word (cur));
+                auto expected = lockfree_detail::word (cur);
+
+                if (prev->next.compare_exchange_strong (expected, lockfree_detail::word (node)))
+                    break;
+            }
+
+            grow_if_needed (size_.fetch_add (1) + 1);
+            return true;
+        }
+
+        bool contains (T const& value) const {
+            return contains_ (value);
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        bool contains (K const& key) const {
+            return contains_ (key);
+        }
+
+        // копия найденного элемента: указатель на узел за пределами
+        // операции мог бы пережить его удаление
+        std::optional<T> find (T const& value) const {
+            return find_ (value);
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        std::optional<T> find (K const& key) const {
+            return find_ (key);
+        }
+
+        // вызывает f (value const&), пока узел гарантированно жив
+        template <typename K, typename F>
+        bool visit (K const& key, F f) const {
+            Guard guard {*this};
+            auto hash = hasher (key);
+            Head* prev;
+            Head* cur;
+
+            if (not search (bucket_head (hash, guard), regular_key (hash), &key, prev, cur, guard))
+                return false;
+
+            f (static_cast<Node*> (cur)->value);
+            return true;
+        }
+
+        // true, если элемент был и удалён
+        bool erase (T const& value) {
+            return erase_ (value);
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        bool erase (K const& key) {
+            return erase_ (key);
+        }
+
+    private:
+        template <typename K>
+        bool contains_ (K const& key) const {
+            return visit (key, [] (T const&) {});
+        }
+
+        template <typename K>
+        std::optional<T> find_ (K const& key) const {
+            std::optional<T> res;
+            visit (key, [&] (T const& value) {
+                res.emplace (value);
+            });
+            return res;
+        }
+
+        template <typename K>
+        bool erase_ (K const& key) {
+            Guard guard {*this};
+            auto hash = hasher (key);
+            auto soKey = regular_key (hash);
+            auto start = bucket_head (hash, guard);
+
+            for (;;) {
+                Head* prev;
+                Head* cur;
+
+                if (not search (start, soKey, &key, prev, cur, guard))
+                    return false;
+
+                // пометка next - логическое удаление, её ставит ровно один поток
+                auto next = cur->next.load();
+                if (lockfree_detail::is_marked (next))
+                    continue;
+
+                if (not cur->next.compare_exchange_strong (next, next | 1))
+                    continue;
+
+                size_.fetch_sub (1);
+
+                auto expected = lockfree_detail::word (cur);
+                if (prev->next.compare_exchange_strong (expected, next)) {
+                    guard.retire (cur);
+                } else {
+                    search (start, soKey, &key, prev, cur, guard);
+                }
+                return true;
+            }
+        }
+
+        // ищет в списке, начиная со стража start, узел с ключом soKey, равный key
+        // (key == nullptr - ищется страж). prev - последний узел перед позицией.
+        // Встреченные помеченные узлы попутно вырезаются из списка
+        template <typename K>
+        bool search (
+            Head* start, std::size_t soKey, K const* key, Head*& prev, Head*& cur, Guard& guard
+        ) const {
+        retry:
+            prev = start;
+            auto curWord = prev->next.load();
+
+            for (;;) {
+                cur = lockfree_detail::ptr (curWord);
+                if (cur == nullptr)
+                    return false;
+
+                auto next = cur->next.load();
+
+                if (lockfree_detail::is_marked (next)) {
+                    auto unmarked = next & ~Word (1);
+                    if (not prev->next.compare_exchange_strong (curWord, unmarked))
+                        goto retry;
+
+                    guard.retire (cur);
+                    curWord = unmarked;
+                    continue;
+                }
+
+                if (cur->soKey > soKey)
+                    return false;
+
+                if (cur->soKey == soKey) {
+                    if (key == nullptr or keyEq (*key, static_cast<Node*> (cur)->value))
+                        return true;
+                }
+
+                prev = cur;
+                curWord = next;
+            }
+        }
+
+        // старший бит хеша жертвуется под признак элемента
+        static
+        std::size_t regular_key (std::size_t hash) noexcept {
+            return lockfree_detail::reverse_bits (hash) | 1;
+        }
+
+        static
+        std::size_t sentinel_key (std::size_t ind) noexcept {
+            return lockfree_detail::reverse_bits (ind);
+        }
+
+        Head* bucket_head (std::size_t hash, Guard& guard) const {
+            return init_bucket (hash & (bucketsCnt.load() - 1), guard);
+        }
+
+        // страж корзины вставляется после стража родительской корзины -
+        // той, из которой она выделилась при удвоении
+        Head* init_bucket (std::size_t ind, Guard& guard) const {
+            auto& slot = bucket (ind);
+            if (auto head = slot.load())
+                return head;
+
+            auto parentInd = ind & ~(std::size_t (1) << lockfree_detail::highest_bit (ind));
+            auto parent = init_bucket (parentInd, guard);
+
+            auto sentinel = new Head;
+            sentinel->soKey = sentinel_key (ind);
+
+            for (;;) {
+                Head* prev;
+                Head* cur;
+
+                if (search (parent, sentinel->soKey, static_cast<T const*> (nullptr), prev, cur, guard)) {
+                    delete sentinel;
+                    sentinel = cur;
+                    break;
+                }
+
+                sentinel->next.store (lockfree_detail::word (cur));
+                auto expected = lockfree_detail::word (cur);
+
+                if (prev->next.compare_exchange_strong (expected, lockfree_detail::word (sentinel)))
+                    break;
+            }
+
+            slot.store (sentinel);
+            return sentinel;
+        }
+
+        void grow_if_needed (std::size_t newSize) {
+            auto cnt = bucketsCnt.load();
+
+            if (newSize > cnt * maxLoad and cnt < maxBucketsCnt) {
+                bucketsCnt.compare_exchange_strong (cnt, cnt * 2);
+            }
+        }
+
+        // сегмент s хранит корзины [2^s, 2^(s+1)), нулевой - корзины 0 и 1;
+        // сегменты не перевыделяются, поэтому корзины не переезжают
+        Bucket& bucket (std::size_t ind) const {
+            auto seg = ind < 2 ? 0 : lockfree_detail::highest_bit (ind);
+            auto first = seg == 0 ? 0 : std::size_t (1) << seg;
+            auto segSize = seg == 0 ? 2 : first;
+
+            auto segment = segments[seg].load();
+            if (segment == nullptr) {
+                auto fresh = new Bucket[segSize]();
+                if (segments[seg].compare_exchange_strong (segment, fresh)) {
+                    segment = fresh;
+                } else {
+                    delete[] fresh;
+                }
+            }
+            return segment[ind - first];
+        }
+
+        Record* acquire_record() const {
+            for (auto rec = records.load(); rec; rec = rec->next) {
+                bool expected = false;
+                if (rec->inUse.compare_exchange_strong (expected, true))
+                    return rec;
+            }
+
+            auto rec = new Record;
+            rec->inUse.store (true);
+            rec->next = records.load();
+
+            while (not records.compare_exchange_weak (rec->next, rec)) {}
+            return rec;
+        }
+
+        void retire (Record& rec, Head* head) const {
+            rec.retired.push_back ({head, epoch.load()});
+
+            if (rec.retired.size() >= reclaimBatch) {
+                try_advance_epoch();
+                reclaim (rec);
+            }
+        }
+
+        // эпоха сдвигается, только когда все активные потоки в текущей
+        void try_advance_epoch() const noexcept {
+            auto cur = epoch.load();
+
+            for (auto rec = records.load(); rec; rec = rec->next) {
+                auto local = rec->local.load();
+                if ((local & 1) and (local >> 1) != cur)
+                    return;
+            }
+
+            epoch.compare_exchange_strong (cur, cur + 1);
+        }
+
+        // узел, удалённый в эпоху e, уже никто не видит, если эпоха дошла до e + 2
+        void reclaim (Record& rec) const noexcept {
+            auto cur = epoch.load();
+            std::size_t kept = 0;
+
+            for (std::size_t i = 0; i < rec.retired.size(); ++i) {
+                if (rec.retired[i].second + 2 <= cur) {
+                    destroy (rec.retired[i].first);
+                } else {
+                    rec.retired[kept++] = rec.retired[i];
+                }
+            }
+
+            while (rec.retired.size() != kept) {
+                rec.retired.pop_back();
+            }
+        }
+
+        static
+        void destroy (Head* head) noexcept {
+            if (head->soKey & 1) {
+                delete static_cast<Node*> (head);
+            } else {
+                delete head;
+            }
+        }
+
+    private:
+        static constexpr std::size_t maxLoad = 2;
+        static constexpr std::size_t maxBucketsCnt = std::size_t (1) << 48;
+        static constexpr std::size_t reclaimBatch = 64;
+
+        Hash hasher{};
+        Eq keyEq{};
+
+        mutable std::atomic<Bucket*> segments[64] = {};
+        std::atomic<std::size_t> bucketsCnt {2};
+        std::atomic<std::size_t> size_ {0};
+
+        mutable std::atomic<std::uint64_t> epoch {1};
+        mutable std::atomic<Record*> records {nullptr};
+    };
+}
+
+#endif
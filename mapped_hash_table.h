@@ -0,0 +1,450 @@
+#ifndef MY_MAPPED_HASH_TABLE_H_GUARD
+#define MY_MAPPED_HASH_TABLE_H_GUARD
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dynamic_array.h"
+#include "flat_hash_set.h"
+#include "hash_table.h"
+
+namespace mapped_detail
+{
+    constexpr std::uint64_t magic = 0x3150414D48534144ull;  // "DASHMAP1"
+    constexpr std::uint32_t version = 1;
+
+
+    // файл: заголовок, управляющие байты (как в FlatHashSet), ячейки с T.
+    // Ячейки выровнены по 64 от начала файла, а mmap отдаёт адрес
+    // с выравниванием по странице
+    struct Header {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t groupWidth;
+        std::uint64_t elemSize;
+        std::uint64_t elemAlign;
+        std::uint64_t size;
+        std::uint64_t capacity;
+        std::uint64_t slotsOffset;
+    };
+
+
+    constexpr std::size_t slotsAlign = 64;
+
+
+    inline std::size_t slots_offset (std::size_t capacity) noexcept {
+        auto end = sizeof(Header) + capacity;
+        return (end + slotsAlign - 1) / slotsAlign * slotsAlign;
+    }
+}
+
+
+namespace data_struct
+{
+    // хеш-множество только для чтения поверх файла, записанного save():
+    // открытие - один mmap, без разбора и без аллокаций.
+    // Годится для тривиально копируемых T (числа, Pair, FixedString).
+    // Hash должен давать одинаковые значения в разных процессах - как
+    // встроенные Hasher с одинаковым seed. Раскладка групп зависит от
+    // ширины Group (SSE2/AVX2), её несовпадение обнаруживается при открытии
+    template <typename T, typename Hash = Hasher<T>, typename Eq = DefaultEqual<T>>
+    class MappedHashSet {
+        using ctrl_t = flat_detail::ctrl_t;
+        using Group = flat_detail::Group;
+        using Header = mapped_detail::Header;
+        using IterImpl = flat_detail::IterImpl<T, MappedHashSet>;
+
+        static_assert (std::is_trivially_copyable_v<T>, "в снимок пишутся только тривиально копируемые типы");
+
+        template <typename K>
+        using EnableIfTransparent = std::enable_if_t<
+            hash_detail::IsTransparent<Hash, K>::value
+        and hash_detail::IsTransparent<Eq, K>::value
+        >;
+
+    public:
+        using iterator       = ForwardIterator<T, IterImpl, Const_tag>;
+        using const_iterator = iterator;
+
+    public:
+        explicit MappedHashSet (char const* path, Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : hasher (hash)
+            , keyEq (eq)
+        {
+            map_file (path);
+        }
+
+        MappedHashSet (MappedHashSet&& rhs) noexcept
+            : hasher (rhs.hasher)
+            , keyEq (rhs.keyEq)
+            , mem (std::exchange (rhs.mem, nullptr))
+            , memSize (std::exchange (rhs.memSize, 0))
+            , ctrl (std::exchange (rhs.ctrl, nullptr))
+            , slots (std::exchange (rhs.slots, nullptr))
+            , capacity_ (std::exchange (rhs.capacity_, 0))
+            , size_ (std::exchange (rhs.size_, 0))
+        {}
+
+        MappedHashSet& operator= (MappedHashSet&& rhs) noexcept {
+            if (this != &rhs) {
+                auto tmp {std::move (rhs)};
+                swap (tmp);
+            }
+            return *this;
+        }
+
+        MappedHashSet (MappedHashSet const&) = delete;
+        MappedHashSet& operator= (MappedHashSet const&) = delete;
+
+        ~MappedHashSet() noexcept {
+            if (mem) {
+                ::munmap (mem, memSize);
+            }
+        }
+
+        void swap (MappedHashSet& rhs) noexcept {
+            std::swap (hasher, rhs.hasher);
+            std::swap (keyEq, rhs.keyEq);
+            std::swap (mem, rhs.mem);
+            std::swap (memSize, rhs.memSize);
+            std::swap (ctrl, rhs.ctrl);
+            std::swap (slots, rhs.slots);
+            std::swap (capacity_, rhs.capacity_);
+            std::swap (size_, rhs.size_);
+        }
+
+        // раскладка строится в памяти и пишется одним проходом; повторы
+        // в [beg, end) пропускаются
+        template <class Iter, class = EnableIfForward<Iter>>
+        static void save (char const* path, Iter beg, Iter end, Hash const& hash = Hash{}, Eq const& eq = Eq{}) {
+            std::size_t count = 0;
+            for (auto it = beg; it != end; ++it) {
+                ++count;
+            }
+
+            auto capacity = capacity_for (count);
+            DynamicArray<ctrl_t> ctrlBuf;
+            DynamicArray<char> slotsBuf;
+            ctrlBuf.resize (capacity);
+            slotsBuf.resize (capacity * sizeof(T));
+
+            for (std::size_t i = 0; i < capacity; ++i) {
+                ctrlBuf[i] = flat_detail::Empty;
+            }
+
+            auto slotsPtr = reinterpret_cast<T*> (&slotsBuf[0]);
+            std::size_t size = 0;
+
+            for (; beg != end; ++beg) {
+                T const& value = *beg;
+                auto h = hash (value);
+
+                if (find_in (&ctrlBuf[0], slotsPtr, capacity, h, value, eq) != capacity)
+                    continue;
+
+                auto ind = find_free_in (&ctrlBuf[0], capacity, h);
+                ctrlBuf[ind] = flat_detail::h2 (h);
+                std::memcpy (&slotsBuf[ind * sizeof(T)], &value, sizeof(T));
+                ++size;
+            }
+
+            Header header {
+                mapped_detail::magic, mapped_detail::version, Group::width
+              , sizeof(T), alignof(T), size, capacity, mapped_detail::slots_offset (capacity)
+            };
+            write_file (path, header, &ctrlBuf[0], &slotsBuf[0]);
+        }
+
+        template <class Container>
+        static void save (char const* path, Container const& container, Hash const& hash = Hash{}, Eq const& eq = Eq{}) {
+            save (path, container.begin(), container.end(), hash, eq);
+        }
+
+        bool empty() const noexcept {
+            return size_ == 0;
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        const_iterator begin() const noexcept {
+            auto impl = iter_impl (0);
+            impl.skip_free();
+            return impl;
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        const_iterator end() const noexcept {
+            return iter_impl (capacity_);
+        }
+
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        const_iterator find (T const& value) const noexcept {
+            return iter_impl (find_in (ctrl, slots, capacity_, hasher (value), value, keyEq));
+        }
+
+        template <typename K, typename = EnableIfTransparent<K>>
+        const_iterator find (K const& key) const noexcept {
+            return iter_impl (find_in (ctrl, slots, capacity_, hasher (key), key, keyEq));
+        }
+
+        template <typename K = T>
+        bool contains (K const& key) const noexcept {
+            return find (key) != end();
+        }
+
+    private:
+        static
+        std::size_t capacity_for (std::size_t count) noexcept {
+            auto capacity = Group::width * 2;
+
+            while (capacity - capacity / 8 < count) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        // тот же обход групп, что в FlatHashSet::find_index
+        template <typename K>
+        static std::size_t find_in (
+            ctrl_t const* ctrl, T const* slots, std::size_t capacity
+          , std::size_t hash, K const& key, Eq const& eq
+        ) noexcept {
+            if (capacity == 0)
+                return capacity;
+
+            auto mask = capacity / Group::width - 1;
+            auto group = flat_detail::h1 (hash) & mask;
+
+            for (std::size_t step = 1; ; ++step) {
+                auto first = group * Group::width;
+                Group g {ctrl + first};
+
+                for (auto m = g.match (flat_detail::h2 (hash)); m != 0; m &= m - 1) {
+                    auto ind = first + flat_detail::lowest_bit (m);
+                    if (eq (key, slots[ind]))
+                        return ind;
+                }
+
+                if (g.match_empty() != 0 or step > mask)
+                    return capacity;
+
+                group = (group + step) & mask;
+            }
+        }
+
+        static
+        std::size_t find_free_in (ctrl_t const* ctrl, std::size_t capacity, std::size_t hash) noexcept {
+            auto mask = capacity / Group::width - 1;
+            auto group = flat_detail::h1 (hash) & mask;
+
+            for (std::size_t step = 1; ; ++step) {
+                auto first = group * Group::width;
+
+                if (auto m = Group {ctrl + first}.match_empty(); m != 0)
+                    return first + flat_detail::lowest_bit (m);
+
+                group = (group + step) & mask;
+            }
+        }
+
+        static
+        void write_file (char const* path, Header const& header, ctrl_t const* ctrlBuf, char const* slotsBuf) {
+            auto file = std::fopen (path, "wb");
+            if (file == nullptr) throw std::runtime_error (
+                "не удалось создать файл снимка\n"
+            );
+
+            char padding[mapped_detail::slotsAlign] = {};
+            auto paddingSize = header.slotsOffset - sizeof(Header) - header.capacity;
+
+            bool ok = std::fwrite (&header, sizeof(Header), 1, file) == 1
+                  and std::fwrite (ctrlBuf, 1, header.capacity, file) == header.capacity
+                  and std::fwrite (padding, 1, paddingSize, file) == paddingSize
+                  and std::fwrite (slotsBuf, sizeof(T), header.capacity, file) == header.capacity;
+
+            ok = std::fclose (file) == 0 and ok;
+
+            if (not ok) throw std::runtime_error (
+                "не удалось записать файл снимка\n"
+            );
+        }
+
+        void map_file (char const* path) {
+            auto fd = ::open (path, O_RDONLY);
+            if (fd < 0) throw std::runtime_error (
+                "не удалось открыть файл снимка\n"
+            );
+
+            struct stat st;
+            if (::fstat (fd, &st) != 0 or std::size_t (st.st_size) < sizeof(Header)) {
+                ::close (fd);
+                throw std::runtime_error ("файл снимка повреждён\n");
+            }
+
+            memSize = st.st_size;
+            mem = ::mmap (nullptr, memSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close (fd);
+
+            if (mem == MAP_FAILED) {
+                mem = nullptr;
+                throw std::runtime_error ("не удалось отобразить файл снимка\n");
+            }
+
+            Header header;
+            std::memcpy (&header, mem, sizeof(Header));
+
+            if (not valid (header)) {
+                ::munmap (std::exchange (mem, nullptr), memSize);
+                throw std::runtime_error ("файл снимка повреждён или записан для другого типа\n");
+            }
+
+            auto base = static_cast<char*> (mem);
+            ctrl = reinterpret_cast<ctrl_t*> (base + sizeof(Header));
+            slots = reinterpret_cast<T*> (base + header.slotsOffset);
+            capacity_ = header.capacity;
+            size_ = header.size;
+        }
+
+        bool valid (Header const& header) const noexcept {
+            auto groups = header.capacity / Group::width;
+
+            return header.magic == mapped_detail::magic
+               and header.version == mapped_detail::version
+               and header.groupWidth == Group::width
+               and header.elemSize == sizeof(T)
+               and header.elemAlign == alignof(T)
+               and header.capacity % Group::width == 0
+               and groups != 0 and (groups & (groups - 1)) == 0
+               and header.size <= header.capacity
+               and header.slotsOffset == mapped_detail::slots_offset (header.capacity)
+               and header.slotsOffset + header.capacity * sizeof(T) <= memSize;
+        }
+
+        IterImpl iter_impl (std::size_t ind) const noexcept {
+            return IterImpl {ctrl + ind, ctrl + capacity_, slots + ind};
+        }
+
+    private:
+        Hash hasher{};
+        Eq keyEq{};
+
+        void* mem = nullptr;
+        std::size_t memSize = 0;
+
+        // память отображена только для чтения, неконстантные
+        // указатели нужны лишь общему с FlatHashSet итератору
+        ctrl_t* ctrl = nullptr;
+        T* slots = nullptr;
+        std::size_t capacity_ = 0;
+        std::size_t size_ = 0;
+    };
+
+
+    template <typename T, typename Hash, typename Eq>
+    void swap (MappedHashSet<T, Hash, Eq>& lhs, MappedHashSet<T, Hash, Eq>& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+
+
+    // HashTable только для чтения из снимка; Key и Value тривиально
+    // копируемы, строки - FixedString
+    template <
+        typename Key
+      , typename Value
+      , typename Hash = KeyValueHash<Key, Value>
+      , typename Eq = KeyValueEqual<Key, Value>
+    >
+    class MappedHashTable {
+        using Elem = Pair<Key, Value>;
+        using Impl = MappedHashSet<Elem, Hash, Eq>;
+
+    public:
+        using iterator       = typename Impl::iterator;
+        using const_iterator = typename Impl::const_iterator;
+
+    public:
+        explicit MappedHashTable (char const* path, Hash const& hash = Hash{}, Eq const& eq = Eq{})
+            : impl (path, hash, eq)
+        {}
+
+        template <class Container>
+        static void save (char const* path, Container const& table, Hash const& hash = Hash{}, Eq const& eq = Eq{}) {
+            Impl::save (path, table.begin(), table.end(), hash, eq);
+        }
+
+        void swap (MappedHashTable& rhs) noexcept {
+            impl.swap (rhs.impl);
+        }
+
+        bool empty() const noexcept {
+            return impl.empty();
+        }
+
+        std::size_t size() const noexcept {
+            return impl.size();
+        }
+
+        auto begin() const noexcept {
+            return impl.begin();
+        }
+
+        auto cbegin() const noexcept {
+            return impl.cbegin();
+        }
+
+        auto end() const noexcept {
+            return impl.end();
+        }
+
+        auto cend() const noexcept {
+            return impl.cend();
+        }
+
+        template <typename K = Key>
+        const_iterator find (K const& key) const noexcept {
+            return impl.find (key);
+        }
+
+        template <typename K = Key>
+        bool contains (K const& key) const noexcept {
+            return find (key) != end();
+        }
+
+        template <typename K = Key>
+        Value const& operator[] (K const& key) const {
+            auto it = find (key);
+
+            if (it == end()) throw std::runtime_error (
+                "не существует элемента с таким ключом\n"
+            );
+
+            return it->second;
+        }
+
+    private:
+        Impl impl;
+    };
+
+
+    template <typename Key, typename Value, typename Hash, typename Eq>
+    void swap (MappedHashTable<Key, Value, Hash, Eq>& lhs, MappedHashTable<Key, Value, Hash, Eq>& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+}
+
+#endif
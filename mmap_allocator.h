@@ -0,0 +1,215 @@
+#ifndef MY_MMAP_ALLOCATOR_H_GUARD
+#define MY_MMAP_ALLOCATOR_H_GUARD
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mmap_detail
+{
+    constexpr std::size_t hugePageSize = std::size_t (2) << 20;
+
+
+    inline std::size_t page_size() noexcept {
+        static const std::size_t size = std::size_t (::sysconf (_SC_PAGESIZE));
+        return size;
+    }
+
+
+    inline std::size_t round_up (std::size_t bytes, std::size_t unit) noexcept {
+        return (bytes + unit - 1) / unit * unit;
+    }
+}
+
+
+namespace data_struct
+{
+    enum class HugePages {
+        None,
+        Transparent,    // madvise (MADV_HUGEPAGE), ядро собирает 2 МБ страницы само
+        Explicit        // MAP_HUGETLB из заранее выделенного пула, без пула - как Transparent
+    };
+
+
+    // распределитель для больших массивов простых структур: буферы от
+    // mmapThreshold байт берутся прямо у системы через mmap и растут через
+    // mremap - ядро переставляет страницы, байты не копируются, и пик памяти
+    // при росте не превышает новый размер. При сжатии хвост возвращается
+    // системе. Мелкие буферы - через malloc/realloc.
+    // reallocate переносит байты как есть, поэтому DynamicArray зовёт его
+    // только для IsTriviallyRelocatable<T>. mremap есть только в Linux,
+    // в остальных POSIX-системах рост идёт копированием
+    template <typename T>
+    class MmapAllocator {
+        static_assert (alignof(T) <= alignof(std::max_align_t), "mmap и malloc не дают большего выравнивания");
+
+    public:
+        using value_type = T;
+
+        // режим страниц уходит вместе с буфером: munmap должен знать длину
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        static constexpr std::size_t mmapThreshold = std::size_t (1) << 20;
+
+    public:
+        MmapAllocator() noexcept = default;
+
+        explicit MmapAllocator (HugePages pages_) noexcept
+            : pages (pages_)
+        {}
+
+        template <typename U>
+        MmapAllocator (MmapAllocator<U> const& rhs) noexcept
+            : pages (rhs.huge_pages())
+        {}
+
+        T* allocate (std::size_t count) {
+            return static_cast<T*> (allocate_bytes (bytes_for (count)));
+        }
+
+        void deallocate (T* ptr, std::size_t count) noexcept {
+            free_bytes (ptr, count * sizeof(T));
+        }
+
+        // буфер из oldCount элементов становится буфером из newCount (больше
+        // или меньше); при нехватке памяти - std::bad_alloc, старый буфер цел
+        T* reallocate (T* ptr, std::size_t oldCount, std::size_t newCount) {
+            auto oldBytes = oldCount * sizeof(T);
+            auto newBytes = bytes_for (newCount);
+
+            if (ptr == nullptr)
+                return allocate (newCount);
+
+            if (newCount == 0) {
+                free_bytes (ptr, oldBytes);
+                return nullptr;
+            }
+
+            if (not mapped (oldBytes) and not mapped (newBytes)) {
+                auto res = std::realloc (ptr, newBytes);
+                if (res == nullptr)
+                    throw std::bad_alloc{};
+
+                return static_cast<T*> (res);
+            }
+
+        #if defined(MREMAP_MAYMOVE)
+            if (mapped (oldBytes) and mapped (newBytes)) {
+                auto oldSize = map_size (oldBytes);
+                auto newSize = map_size (newBytes);
+
+                if (oldSize == newSize)
+                    return ptr;
+
+                auto res = ::mremap (ptr, oldSize, newSize, MREMAP_MAYMOVE);
+                if (res != MAP_FAILED) {
+                    advise (res, newSize);
+                    return static_cast<T*> (res);
+                }
+            }
+        #endif
+
+            // переход через порог или mremap отказал (hugetlb): копия
+            auto res = allocate_bytes (newBytes);
+            std::memcpy (res, ptr, oldBytes < newBytes ? oldBytes : newBytes);
+            free_bytes (ptr, oldBytes);
+            return static_cast<T*> (res);
+        }
+
+        HugePages huge_pages() const noexcept {
+            return pages;
+        }
+
+        friend bool operator== (MmapAllocator const& lhs, MmapAllocator const& rhs) noexcept {
+            return lhs.pages == rhs.pages;
+        }
+
+        friend bool operator!= (MmapAllocator const& lhs, MmapAllocator const& rhs) noexcept {
+            return not (lhs == rhs);
+        }
+
+    private:
+        static
+        std::size_t bytes_for (std::size_t count) {
+            if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+                throw std::bad_alloc{};
+
+            return count * sizeof(T);
+        }
+
+        static
+        bool mapped (std::size_t bytes) noexcept {
+            return bytes >= mmapThreshold;
+        }
+
+        // для Explicit длина кратна большой странице, такой munmap
+        // подходит и если пула не было и отображение обычное
+        std::size_t map_size (std::size_t bytes) const noexcept {
+            auto unit = pages == HugePages::Explicit ? mmap_detail::hugePageSize : mmap_detail::page_size();
+            return mmap_detail::round_up (bytes, unit);
+        }
+
+        void* allocate_bytes (std::size_t bytes) const {
+            if (not mapped (bytes)) {
+                auto res = std::malloc (bytes == 0 ? 1 : bytes);
+                if (res == nullptr)
+                    throw std::bad_alloc{};
+
+                return res;
+            }
+
+            auto size = map_size (bytes);
+            auto res = MAP_FAILED;
+
+        #if defined(MAP_HUGETLB)
+            if (pages == HugePages::Explicit) {
+                res = ::mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            }
+        #endif
+
+            if (res == MAP_FAILED) {
+                res = ::mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            }
+
+            if (res == MAP_FAILED)
+                throw std::bad_alloc{};
+
+            advise (res, size);
+            return res;
+        }
+
+        void free_bytes (void* ptr, std::size_t bytes) const noexcept {
+            if (ptr == nullptr)
+                return;
+
+            if (mapped (bytes)) {
+                ::munmap (ptr, map_size (bytes));
+            } else {
+                std::free (ptr);
+            }
+        }
+
+        void advise (void* ptr, std::size_t size) const noexcept {
+        #if defined(MADV_HUGEPAGE)
+            if (pages != HugePages::None and size >= mmap_detail::hugePageSize) {
+                ::madvise (ptr, size, MADV_HUGEPAGE);
+            }
+        #else
+            (void) ptr;
+            (void) size;
+        #endif
+        }
+
+    private:
+        HugePages pages = HugePages::Transparent;
+    };
+}
+
+#endif
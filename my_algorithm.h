@@ -129,15 +129,15 @@ namespace algs
     }
 
 
-    template <typename T, template <typename P> class Container>
-    auto inserter (Container<T>& container, typename Container<T>::const_iterator it) {
-        return data_struct::InserterIterator<T, Container<T>> (container, it);
+    template <typename T, template <typename P, typename... Ps> class Container, typename... Rest>
+    auto inserter (Container<T, Rest...>& container, typename Container<T, Rest...>::const_iterator it) {
+        return data_struct::InserterIterator<T, Container<T, Rest...>> (container, it);
     }
 
 
-    template <typename T, template <typename P> class Container>
-    auto back_inserter (Container<T>& container) {
-        return data_struct::BackInserterIterator<T, Container<T>> (container);
+    template <typename T, template <typename P, typename... Ps> class Container, typename... Rest>
+    auto back_inserter (Container<T, Rest...>& container) {
+        return data_struct::BackInserterIterator<T, Container<T, Rest...>> (container);
     }    
 }
 
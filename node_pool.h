@@ -0,0 +1,278 @@
+#ifndef MY_NODE_POOL_H_GUARD
+#define MY_NODE_POOL_H_GUARD
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pool_detail
+{
+    // узлы одного размера нарезаются из слябов, слябы растут вдвое;
+    // освобождённые узлы идут в список свободных. Слябы возвращаются
+    // системе только вместе с пулом
+    class SizeClass {
+        struct FreeNode {
+            FreeNode* next;
+        };
+
+        struct Slab {
+            Slab* prev;
+        };
+
+        static constexpr std::size_t firstSlabNodes = 32;
+        static constexpr std::size_t maxSlabNodes = 1024;
+
+    public:
+        SizeClass() noexcept = default;
+        SizeClass (SizeClass const&) = delete;
+        SizeClass& operator= (SizeClass const&) = delete;
+
+        ~SizeClass() noexcept {
+            while (slabs) {
+                auto prev = slabs->prev;
+                ::operator delete (slabs, std::align_val_t (align));
+                slabs = prev;
+            }
+        }
+
+        bool empty() const noexcept {
+            return size == 0;
+        }
+
+        void init (std::size_t size_, std::size_t align_) noexcept {
+            align = align_ < alignof(FreeNode) ? alignof(FreeNode) : align_;
+            size = (size_ < sizeof(FreeNode) ? sizeof(FreeNode) : size_);
+            size = (size + align - 1) / align * align;
+            claimed = size_;
+        }
+
+        bool serves (std::size_t size_, std::size_t align_) const noexcept {
+            return claimed == size_ and align_ <= align;
+        }
+
+        void* allocate() {
+            if (freeList == nullptr) {
+                add_slab();
+            }
+
+            auto res = freeList;
+            freeList = res->next;
+            return res;
+        }
+
+        void deallocate (void* ptr) noexcept {
+            auto node = static_cast<FreeNode*> (ptr);
+            node->next = freeList;
+            freeList = node;
+        }
+
+    private:
+        // заголовок занимает целое число узлов, чтобы узлы остались выровнены;
+        // узлы выдаются по порядку адресов - соседние вставки рядом в памяти
+        void add_slab() {
+            auto header = (sizeof(Slab) + size - 1) / size * size;
+            auto mem = static_cast<char*> (
+                ::operator new (header + size * slabNodes, std::align_val_t (align))
+            );
+
+            auto slab = reinterpret_cast<Slab*> (mem);
+            slab->prev = slabs;
+            slabs = slab;
+
+            for (std::size_t i = slabNodes; i-- > 0; ) {
+                deallocate (mem + header + i * size);
+            }
+
+            if (slabNodes < maxSlabNodes) {
+                slabNodes *= 2;
+            }
+        }
+
+    private:
+        std::size_t claimed = 0;
+        std::size_t size = 0;
+        std::size_t align = 0;
+        std::size_t slabNodes = firstSlabNodes;
+
+        Slab* slabs = nullptr;
+        FreeNode* freeList = nullptr;
+    };
+
+
+    // общее состояние всех копий распределителя (и пересвязанных тоже).
+    // Классов размера несколько: у HashSet, например, свои узлы и свои
+    // одиночные блоки. Не потокобезопасно, счётчик ссылок не атомарный
+    class SlabPool {
+    public:
+        static constexpr std::size_t maxClasses = 4;
+
+    public:
+        void* allocate (std::size_t size, std::size_t align) {
+            if (auto cls = find (size, align, true))
+                return cls->allocate();
+
+            return ::operator new (size, std::align_val_t (align));
+        }
+
+        void deallocate (void* ptr, std::size_t size, std::size_t align) noexcept {
+            if (auto cls = find (size, align, false)) {
+                cls->deallocate (ptr);
+            } else {
+                ::operator delete (ptr, std::align_val_t (align));
+            }
+        }
+
+        // классы раздаются первым встреченным размерам; освобождается блок
+        // того же размера, поэтому он всегда найдёт тот же класс
+        SizeClass* find (std::size_t size, std::size_t align, bool claim) noexcept {
+            for (auto& cls : classes) {
+                if (cls.empty()) {
+                    if (not claim)
+                        return nullptr;
+
+                    cls.init (size, align);
+                    return &cls;
+                }
+
+                if (cls.serves (size, align))
+                    return &cls;
+            }
+            return nullptr;
+        }
+
+    public:
+        std::size_t refs = 1;
+
+    private:
+        SizeClass classes[maxClasses];
+    };
+}
+
+
+namespace data_struct
+{
+    // распределитель узлов для List, FList, Queue и HashSet: одиночные узлы
+    // берутся из слябов общего пула, освобождённые узлы используются снова,
+    // так что в установившемся режиме (очередь, вставки и удаления в
+    // множестве) аллокаций нет, а соседние узлы лежат рядом.
+    // Пул создаётся при первой аллокации узла: пустой контейнер памяти не
+    // берёт. Копии и пересвязанные копии делят пул, если он уже был, слябы
+    // освобождаются вместе с последней копией - то есть с контейнером.
+    // HashSet создаёт его через alloc_detail::share до раздачи копий корзинам,
+    // поэтому у него тоже один пул. Копия контейнера (и при присваивании тоже)
+    // получает свой пул. Массивы (count > 1) идут мимо пула.
+    // Контейнер с таким распределителем нельзя менять из разных потоков
+    template <typename T>
+    class NodePoolAllocator {
+        template <typename U>
+        friend class NodePoolAllocator;
+
+    public:
+        using value_type = T;
+
+        // пул уходит вместе с узлами; копирующее присваивание оставляет
+        // свой пул, иначе два контейнера делили бы неатомарный счётчик
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+
+    public:
+        NodePoolAllocator() noexcept = default;
+
+        NodePoolAllocator (NodePoolAllocator const& rhs) noexcept
+            : pool (rhs.pool)
+        {
+            ref();
+        }
+
+        template <typename U>
+        NodePoolAllocator (NodePoolAllocator<U> const& rhs) noexcept
+            : pool (rhs.pool)
+        {
+            ref();
+        }
+
+        NodePoolAllocator& operator= (NodePoolAllocator const& rhs) noexcept {
+            NodePoolAllocator tmp {rhs};
+            std::swap (pool, tmp.pool);
+            return *this;
+        }
+
+        ~NodePoolAllocator() noexcept {
+            unref();
+        }
+
+        // пул создаётся заранее, чтобы дальнейшие копии его делили
+        void share() {
+            own_pool();
+        }
+
+        T* allocate (std::size_t count) {
+            if (count == 1)
+                return static_cast<T*> (own_pool().allocate (sizeof(T), alignof(T)));
+
+            if (count > std::size_t (-1) / sizeof(T))
+                throw std::bad_alloc{};
+
+            return static_cast<T*> (::operator new (count * sizeof(T), std::align_val_t (alignof(T))));
+        }
+
+        void deallocate (T* ptr, std::size_t count) noexcept {
+            if (count == 1) {
+                pool->deallocate (ptr, sizeof(T), alignof(T));
+            } else {
+                ::operator delete (ptr, std::align_val_t (alignof(T)));
+            }
+        }
+
+        friend void swap (NodePoolAllocator& lhs, NodePoolAllocator& rhs) noexcept {
+            std::swap (lhs.pool, rhs.pool);
+        }
+
+        NodePoolAllocator select_on_container_copy_construction() const noexcept {
+            return NodePoolAllocator{};
+        }
+
+        template <typename U>
+        friend bool operator== (NodePoolAllocator const& lhs, NodePoolAllocator<U> const& rhs) noexcept {
+            return lhs.same_pool (rhs);
+        }
+
+        template <typename U>
+        friend bool operator!= (NodePoolAllocator const& lhs, NodePoolAllocator<U> const& rhs) noexcept {
+            return not lhs.same_pool (rhs);
+        }
+
+    private:
+        template <typename U>
+        bool same_pool (NodePoolAllocator<U> const& rhs) const noexcept {
+            return pool == rhs.pool;
+        }
+
+        pool_detail::SlabPool& own_pool() {
+            if (pool == nullptr) {
+                pool = new pool_detail::SlabPool;
+            }
+            return *pool;
+        }
+
+        void ref() noexcept {
+            if (pool) {
+                ++pool->refs;
+            }
+        }
+
+        void unref() noexcept {
+            if (pool and --pool->refs == 0) {
+                delete pool;
+            }
+        }
+
+    private:
+        pool_detail::SlabPool* pool = nullptr;
+    };
+}
+
+#endif
@@ -5,13 +5,24 @@
 
 namespace data_struct
 {
-    template <typename T>
+    template <typename T, typename Alloc = std::allocator<T>>
     class Queue {
     public:
-        using iterator       = typename List<T>::iterator;
-        using const_iterator = typename List<T>::const_iterator;
+        using iterator       = typename List<T, Alloc>::iterator;
+        using const_iterator = typename List<T, Alloc>::const_iterator;
+        using allocator_type = Alloc;
 
     public:
+        Queue() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+
+        explicit Queue (Alloc const& alloc) noexcept
+            : impl (alloc)
+        {}
+
+        allocator_type get_allocator() const noexcept {
+            return impl.get_allocator();
+        }
+
         auto begin() const noexcept {
             return impl.cbegin();
         }
@@ -53,6 +64,10 @@ namespace data_struct
             impl.pop_front();
         }
 
+        void clear() noexcept {
+            impl.clear();
+        }
+
         T const& front() const noexcept {
             return impl.front();
         }
@@ -62,13 +77,25 @@ namespace data_struct
         }
 
     private:
-        List<T> impl{};
+        List<T, Alloc> impl{};
     };
 
 
-    template <typename T>
-    void swap (Queue<T>& lhs, Queue<T>& rhs) noexcept {
+    template <typename T, typename Alloc>
+    void swap (Queue<T, Alloc>& lhs, Queue<T, Alloc>& rhs) noexcept {
         lhs.swap (rhs);
     }
+
+
+    // push_back/pop_front в установившемся режиме без аллокаций
+    template <typename T>
+    using PooledQueue = Queue<T, NodePoolAllocator<T>>;
+
+
+    namespace pmr
+    {
+        template <typename T>
+        using Queue = data_struct::Queue<T, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 #endif
\ No newline at end of file
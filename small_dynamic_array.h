@@ -0,0 +1,526 @@
+#ifndef MY_SMALL_DYNAMIC_ARRAY_H_GUARD
+#define MY_SMALL_DYNAMIC_ARRAY_H_GUARD
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "dynamic_array.h"
+
+namespace data_struct
+{
+    // DynamicArray, первые N элементов которого лежат прямо в объекте:
+    // до N элементов нет ни одной аллокации, дальше буфер в куче растёт
+    // вдвое, начиная с 2N. shrink_to_fit возвращает элементы внутрь,
+    // если они туда помещаются.
+    // Перемещение массива, лежащего внутри, переносит элементы по одному,
+    // итераторы при этом, в отличие от DynamicArray, недействительны
+    template <typename T, std::size_t N, typename Alloc = std::allocator<T>>
+    class SmallDynamicArray : private Alloc {
+        static_assert (N > 0, "для N = 0 используйте DynamicArray");
+
+        using IterImpl = array_detail::IterImpl<T, SmallDynamicArray>;
+        using AllocTraits = std::allocator_traits<Alloc>;
+
+        static constexpr bool nothrowRelocate = IsTriviallyRelocatable<T>::value
+                                             or std::is_nothrow_move_constructible_v<T>;
+
+    public:
+        using iterator       = RandomIterator<T, IterImpl, Mutable_tag>;
+        using const_iterator = RandomIterator<T, IterImpl, Const_tag>;
+        using allocator_type = Alloc;
+
+        static constexpr std::size_t inlineCapacity = N;
+
+    public:
+        SmallDynamicArray() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+
+        explicit SmallDynamicArray (Alloc const& alloc) noexcept
+            : Alloc (alloc)
+        {}
+
+        SmallDynamicArray (SmallDynamicArray&& rhs) noexcept (nothrowRelocate)
+            : Alloc (rhs.alloc())
+        {
+            take (rhs);
+        }
+
+        template <class Iter, class = EnableIfForward<Iter>>
+        SmallDynamicArray (Iter beg, Iter end, Alloc const& alloc = Alloc{})
+            : Alloc (alloc)
+        {
+            for (; beg != end; ++beg) {
+                emplace_back (*beg);
+            }
+        }
+
+        SmallDynamicArray (std::initializer_list<T> iList, Alloc const& alloc = Alloc{})
+            : Alloc (alloc)
+        {
+            copy_init (iList.begin(), iList.size());
+        }
+
+        SmallDynamicArray (SmallDynamicArray const& rhs)
+            : SmallDynamicArray (rhs, alloc_detail::select_for_copy (rhs.alloc()))
+        {}
+
+        SmallDynamicArray (SmallDynamicArray const& rhs, Alloc const& alloc)
+            : Alloc (alloc)
+        {
+            copy_init (rhs.begin_, rhs.size());
+        }
+
+        SmallDynamicArray (std::size_t count, T const& value = T(), Alloc const& alloc = Alloc{})
+            : Alloc (alloc)
+        {
+            reserve (count);
+            while (count--) {
+                new (end_) T {value};
+                ++end_;
+            }
+        }
+
+        // буфер из кучи забирается, если его можно вернуть через свой
+        // распределитель, иначе элементы переносятся по одному
+        SmallDynamicArray& operator= (SmallDynamicArray&& rhs) noexcept (nothrowRelocate and AllocTraits::is_always_equal::value) {
+            if (this == &rhs)
+                return *this;
+
+            if (not rhs.is_inline() and alloc_detail::can_take_storage (alloc(), rhs.alloc())) {
+                release();
+                if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                    alloc() = rhs.alloc();
+                }
+                take (rhs);
+            } else {
+                clear();
+                reserve (rhs.size());
+                move_init (rhs.begin_, rhs.size());
+                rhs.clear();
+            }
+            return *this;
+        }
+
+        SmallDynamicArray& operator= (SmallDynamicArray const& rhs) {
+            if (this != &rhs) {
+                SmallDynamicArray tmp {rhs, alloc_detail::for_copy_assign (alloc(), rhs.alloc())};
+                *this = std::move (tmp);
+            }
+            return *this;
+        }
+
+        ~SmallDynamicArray() noexcept {
+            release();
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return alloc();
+        }
+
+        // элементы лежат внутри объекта
+        bool is_inline() const noexcept {
+            return begin_ == inline_data();
+        }
+
+        auto begin() noexcept {
+            return iterator {begin_};
+        }
+
+        auto cbegin() const noexcept {
+            return const_iterator {no_const (begin_)};
+        }
+
+        auto begin() const noexcept {
+            return cbegin();
+        }
+
+        auto end() noexcept {
+            return iterator {end_};
+        }
+
+        auto cend() const noexcept {
+            return const_iterator {no_const (end_)};
+        }
+
+        auto end() const noexcept {
+            return cend();
+        }
+
+        T& operator[] (std::size_t ind) noexcept {
+            return begin_[ind];
+        }
+
+        T const& operator[] (std::size_t ind) const noexcept {
+            return begin_[ind];
+        }
+
+        T& front () noexcept {
+            return *begin_;
+        }
+
+        T const& front () const noexcept {
+            return *begin_;
+        }
+
+        T& back () noexcept {
+            return end_[-1];
+        }
+
+        T const& back () const noexcept {
+            return end_[-1];
+        }
+
+        // без аллокаций: внутренние элементы переезжают, буферы в куче
+        // меняются местами. Без propagate_on_container_swap распределители
+        // должны быть равны, как и у DynamicArray
+        void swap (SmallDynamicArray& rhs) noexcept (nothrowRelocate and std::is_nothrow_swappable_v<T>) {
+            if (this == &rhs)
+                return;
+
+            if (is_inline() and rhs.is_inline()) {
+                swap_inline (rhs);
+            } else if (is_inline() or rhs.is_inline()) {
+                auto& small = is_inline() ? *this : rhs;
+                auto& big = is_inline() ? rhs : *this;
+                auto count = small.size();
+                auto heapBegin = big.begin_;
+                auto heapEnd = big.end_;
+
+                relocate (small.begin_, count, big.inline_data());
+                big.begin_ = big.inline_data();
+                big.end_ = big.begin_ + count;
+
+                small.begin_ = heapBegin;
+                small.end_ = heapEnd;
+                std::swap (capacity_, rhs.capacity_);
+            } else {
+                std::swap (capacity_, rhs.capacity_);
+                std::swap (begin_, rhs.begin_);
+                std::swap (end_, rhs.end_);
+            }
+
+            alloc_detail::swap (alloc(), rhs.alloc());
+        }
+
+        std::size_t size() const noexcept {
+            return end_ - begin_;
+        }
+
+        std::size_t capacity() const noexcept {
+            return capacity_;
+        }
+
+        bool empty() const noexcept {
+            return end_ == begin_;
+        }
+
+        template <typename... Ts>
+        void emplace_back (Ts&&... args) {
+            if (end_ == begin_ + capacity_) {
+                realloc_emplace_back (std::forward<Ts> (args)...);
+                return;
+            }
+
+            new (end_) T {std::forward<Ts> (args)...};
+            ++end_;
+        }
+
+        void push_back (T const& value) {
+            emplace_back (value);
+        }
+
+        void push_back (T&& value) {
+            emplace_back (std::move (value));
+        }
+
+        // значение строится до сдвига: args могут ссылаться на элементы
+        template <typename... Ts>
+        iterator emplace (const_iterator it, Ts&&... args) {
+            std::size_t pos = it - cbegin();
+
+            if (pos == size()) {
+                emplace_back (std::forward<Ts> (args)...);
+                return begin() + pos;
+            }
+
+            T value {std::forward<Ts> (args)...};
+            push_back (std::move (back()));
+
+            for (auto ptr = end_ - 2; ptr != begin_ + pos; --ptr) {
+                *ptr = std::move (ptr[-1]);
+            }
+            begin_[pos] = std::move (value);
+
+            return begin() + pos;
+        }
+
+        iterator insert (const_iterator it, T const& value) {
+            return emplace (it, value);
+        }
+
+        iterator insert (const_iterator it, T&& value) {
+            return emplace (it, std::move (value));
+        }
+
+        void pop_back() noexcept {
+            --end_;
+            end_->~T();
+        }
+
+        void erase (const_iterator it) {
+            for (auto ptr = it.real(); ptr + 1 != end_; ++ptr) {
+                *ptr = std::move (ptr[1]);
+            }
+            pop_back();
+        }
+
+        void clear() noexcept {
+            destroy (begin_, end_);
+            end_ = begin_;
+        }
+
+        void reserve (std::size_t newCapacity) {
+            if (capacity_ < newCapacity) {
+                realloc_storage (newCapacity);
+            }
+        }
+
+        // элементы, помещающиеся внутрь, возвращаются туда
+        void shrink_to_fit() {
+            if (is_inline() or capacity_ == size())
+                return;
+
+            if (size() <= N) {
+                auto oldBegin = begin_;
+                auto oldCapacity = capacity_;
+                auto count = size();
+
+                relocate (oldBegin, count, inline_data());
+                begin_ = inline_data();
+                end_ = begin_ + count;
+                capacity_ = N;
+                mem_free (oldBegin, oldCapacity);
+                return;
+            }
+
+            realloc_storage (size());
+        }
+
+        void resize (std::size_t newSize) {
+            reserve (newSize);
+
+            if (newSize < size()) {
+                destroy (begin_ + newSize, end_);
+                end_ = begin_ + newSize;
+            }
+
+            while (size() != newSize) {
+                new (end_) T{};
+                ++end_;
+            }
+        }
+
+    private:
+        Alloc& alloc() noexcept {
+            return *this;
+        }
+
+        Alloc const& alloc() const noexcept {
+            return *this;
+        }
+
+        T* inline_data() noexcept {
+            return reinterpret_cast<T*> (buffer);
+        }
+
+        T const* inline_data() const noexcept {
+            return reinterpret_cast<T const*> (buffer);
+        }
+
+        T* mem_alloc (std::size_t count) {
+            return AllocTraits::allocate (alloc(), count);
+        }
+
+        void mem_free (T* ptr, std::size_t count) noexcept {
+            AllocTraits::deallocate (alloc(), ptr, count);
+        }
+
+        // разрушает элементы и возвращает буфер из кучи; массив снова внутри
+        void release() noexcept {
+            destroy (begin_, end_);
+            if (not is_inline()) {
+                mem_free (begin_, capacity_);
+            }
+
+            begin_ = end_ = inline_data();
+            capacity_ = N;
+        }
+
+        // хвост длинного массива переезжает в короткий, общая часть - обменом
+        void swap_inline (SmallDynamicArray& rhs) noexcept (nothrowRelocate and std::is_nothrow_swappable_v<T>) {
+            auto& shorter = size() < rhs.size() ? *this : rhs;
+            auto& longer = size() < rhs.size() ? rhs : *this;
+            auto common = shorter.size();
+            auto extra = longer.size() - common;
+
+            relocate (longer.begin_ + common, extra, shorter.end_);
+            shorter.end_ += extra;
+            longer.end_ -= extra;
+
+            using std::swap;
+            for (std::size_t i = 0; i < common; ++i) {
+                swap (begin_[i], rhs.begin_[i]);
+            }
+        }
+
+        // *this пуст и внутри; rhs остаётся пустым и внутри
+        void take (SmallDynamicArray& rhs) noexcept (nothrowRelocate) {
+            if (rhs.is_inline()) {
+                auto count = rhs.size();
+                relocate (rhs.begin_, count, begin_);
+                end_ = begin_ + count;
+                rhs.end_ = rhs.begin_;
+                return;
+            }
+
+            begin_ = std::exchange (rhs.begin_, rhs.inline_data());
+            end_ = std::exchange (rhs.end_, rhs.inline_data());
+            capacity_ = std::exchange (rhs.capacity_, N);
+        }
+
+        // места хватает, end_ растёт по мере построения
+        void copy_init (T const* src, std::size_t count) {
+            reserve (count);
+
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                if (count != 0) {
+                    std::memcpy (static_cast<void*> (end_), static_cast<void const*> (src), count * sizeof(T));
+                }
+                end_ += count;
+            } else {
+                for (std::size_t i = 0; i < count; ++i) {
+                    new (end_) T {src[i]};
+                    ++end_;
+                }
+            }
+        }
+
+        void move_init (T* src, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                new (end_) T {std::move (src[i])};
+                ++end_;
+            }
+        }
+
+        static
+        void destroy (T* beg, T* end) noexcept {
+            if constexpr (not std::is_trivially_destructible_v<T>) {
+                for (; beg != end; ++beg) {
+                    beg->~T();
+                }
+            }
+        }
+
+        // count элементов переезжают из src в dst, src разрушаются;
+        // бросающее перемещение заменяется копированием, как в DynamicArray,
+        // и при исключении src остаются на месте (кроме некопируемых типов)
+        static
+        void relocate (T* src, std::size_t count, T* dst) {
+            if constexpr (IsTriviallyRelocatable<T>::value) {
+                if (count != 0) {
+                    std::memcpy (static_cast<void*> (dst), static_cast<void const*> (src), count * sizeof(T));
+                }
+            } else {
+                std::size_t moved = 0;
+                try {
+                    for (; moved < count; ++moved) {
+                        new (dst + moved) T {std::move_if_noexcept (src[moved])};
+                    }
+                } catch (...) {
+                    destroy (dst, dst + moved);
+                    throw;
+                }
+                destroy (src, src + count);
+            }
+        }
+
+        void move_to_heap (T* newBegin, std::size_t newCapacity) {
+            auto count = size();
+            relocate (begin_, count, newBegin);
+
+            if (not is_inline()) {
+                mem_free (begin_, capacity_);
+            }
+            begin_ = newBegin;
+            end_ = newBegin + count;
+            capacity_ = newCapacity;
+        }
+
+        // newCapacity больше N и не меньше size()
+        void realloc_storage (std::size_t newCapacity) {
+            auto newBegin = mem_alloc (newCapacity);
+            try {
+                move_to_heap (newBegin, newCapacity);
+            } catch (...) {
+                mem_free (newBegin, newCapacity);
+                throw;
+            }
+        }
+
+        // новый элемент строится до переезда: args могут ссылаться
+        // на элементы самого массива (push_back (back()))
+        template <typename... Ts>
+        void realloc_emplace_back (Ts&&... args) {
+            auto count = size();
+            auto newCapacity = capacity_ * 2;
+            auto newBegin = mem_alloc (newCapacity);
+
+            try {
+                new (newBegin + count) T {std::forward<Ts> (args)...};
+            } catch (...) {
+                mem_free (newBegin, newCapacity);
+                throw;
+            }
+
+            try {
+                move_to_heap (newBegin, newCapacity);
+            } catch (...) {
+                newBegin[count].~T();
+                mem_free (newBegin, newCapacity);
+                throw;
+            }
+            ++end_;
+        }
+
+        static
+        T* no_const (T const* ptr) noexcept {
+            return const_cast<T*> (ptr);
+        }
+
+    private:
+        std::size_t capacity_ = N;
+
+        T* begin_ = inline_data();
+        T* end_ = begin_;
+
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+    };
+
+
+    template <typename T, std::size_t N, typename Alloc>
+    void swap (SmallDynamicArray<T, N, Alloc>& lhs, SmallDynamicArray<T, N, Alloc>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+
+    namespace pmr
+    {
+        template <typename T, std::size_t N>
+        using SmallDynamicArray = data_struct::SmallDynamicArray<T, N, std::pmr::polymorphic_allocator<T>>;
+    }
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef MY_SNAPSHOT_HASH_TABLE_H_GUARD
+#define MY_SNAPSHOT_HASH_TABLE_H_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include "hash_table.h"
+
+namespace data_struct
+{
+    // таблица для чтения почти без записи, в духе RCU: читатели работают
+    // с неизменяемым снимком и платят за вход одной записью в свой слот,
+    // без атомарных read-modify-write и без блокировок. Писатель строит новую
+    // таблицу, публикует её одним обменом указателя и освобождает старую,
+    // когда все читатели, которые могли её видеть, закончили (grace period).
+    // Писатели между собой упорядочены мьютексом
+    template <
+        typename Key
+      , typename Value
+      , typename Hash = KeyValueHash<Key, Value>
+      , typename Eq = KeyValueEqual<Key, Value>
+      , typename Policy = DefaultHashPolicy
+    >
+    class SnapshotHashTable {
+        using Table = HashTable<Key, Value, Hash, Eq, Policy>;
+
+        // версия, с которой читатель вошёл, 0 - читатель вне снимка
+        struct alignas(64) Slot {
+            std::atomic<std::uint64_t> seen {0};
+            std::atomic<bool> taken {false};
+        };
+
+    public:
+        static constexpr std::size_t defaultMaxReaders = 128;
+
+        // пока жив объект снимка, таблица не будет освобождена
+        class Snapshot {
+        public:
+            Snapshot (Snapshot const&) = delete;
+            Snapshot& operator= (Snapshot const&) = delete;
+
+            Snapshot (Snapshot&& rhs) noexcept
+                : slot (std::exchange (rhs.slot, nullptr))
+                , table (rhs.table)
+            {}
+
+            ~Snapshot() noexcept {
+                if (slot) {
+                    slot->seen.store (0);
+                }
+            }
+
+            Table const& operator*() const noexcept {
+                return *table;
+            }
+
+            Table const* operator->() const noexcept {
+                return table;
+            }
+
+        private:
+            friend SnapshotHashTable;
+
+            Snapshot (Slot* slot_, Table const* table_) noexcept
+                : slot (slot_)
+                , table (table_)
+            {}
+
+            Slot* slot;
+            Table const* table;
+        };
+
+        // у каждого читающего потока свой Reader; одновременно открыт
+        // не больше одного снимка на Reader
+        class Reader {
+        public:
+            Reader (Reader const&) = delete;
+            Reader& operator= (Reader const&) = delete;
+
+            Reader (Reader&& rhs) noexcept
+                : owner (rhs.owner)
+                , slot (std::exchange (rhs.slot, nullptr))
+            {}
+
+            ~Reader() noexcept {
+                if (slot) {
+                    slot->taken.store (false);
+                }
+            }
+
+            Snapshot snapshot() const noexcept {
+                slot->seen.store (owner->version.load());
+                return Snapshot {slot, owner->current.load()};
+            }
+
+            template <typename F>
+            decltype (auto) read (F f) const {
+                auto snap = snapshot();
+                return f (*snap);
+            }
+
+            template <typename K = Key>
+            std::optional<Value> find (K const& key) const {
+                auto snap = snapshot();
+
+                if (auto it = snap->find (key); it != snap->end())
+                    return it->second;
+
+                return std::nullopt;
+            }
+
+        private:
+            friend SnapshotHashTable;
+
+            Reader (SnapshotHashTable const* owner_, Slot* slot_) noexcept
+                : owner (owner_)
+                , slot (slot_)
+            {}
+
+            SnapshotHashTable const* owner;
+            Slot* slot;
+        };
+
+    public:
+        explicit SnapshotHashTable (Table table = Table{}, std::size_t maxReaders = defaultMaxReaders)
+            : current (new Table (std::move (table)))
+            , slots (new Slot[maxReaders])
+            , slotsCnt (maxReaders)
+        {}
+
+        SnapshotHashTable (SnapshotHashTable const&) = delete;
+        SnapshotHashTable& operator= (SnapshotHashTable const&) = delete;
+
+        // все Reader должны быть уничтожены раньше таблицы
+        ~SnapshotHashTable() noexcept {
+            delete current.load();
+        }
+
+    public:
+        // регистрация потока-читателя; единственное место на стороне
+        // читателя с атомарным RMW, делается один раз
+        Reader reader() const {
+            for (std::size_t i = 0; i < slotsCnt; ++i) {
+                bool expected = false;
+                if (slots[i].taken.compare_exchange_strong (expected, true))
+                    return Reader {this, &slots[i]};
+            }
+
+            throw std::runtime_error (
+                "превышено число читателей SnapshotHashTable\n"
+            );
+        }
+
+        // заменяет таблицу целиком; возвращается после освобождения старой
+        void publish (Table table) {
+            std::lock_guard<std::mutex> lock {writeMutex};
+            replace (new Table (std::move (table)));
+        }
+
+        // изменения на копии текущей таблицы: f (Table&)
+        template <typename F>
+        void update (F f) {
+            std::lock_guard<std::mutex> lock {writeMutex};
+
+            auto next = new Table (*current.load());
+            try {
+                f (*next);
+            } catch (...) {
+                delete next;
+                throw;
+            }
+            replace (next);
+        }
+
+    private:
+        void replace (Table* next) {
+            auto old = current.exchange (next);
+            auto newVersion = version.fetch_add (1) + 1;
+
+            synchronize (newVersion);
+            delete old;
+        }
+
+        // ждёт, пока каждый читатель выйдет из снимка или войдёт в новый.
+        // Читатель пишет слот до чтения current, писатель меняет current до
+        // чтения слотов (всё seq_cst), поэтому если писатель видит слот пустым,
+        // читатель увидит уже новую таблицу
+        void synchronize (std::uint64_t newVersion) const noexcept {
+            for (std::size_t i = 0; i < slotsCnt; ++i) {
+                for (;;) {
+                    auto seen = slots[i].seen.load();
+                    if (seen == 0 or seen >= newVersion)
+                        break;
+
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+    private:
+        std::atomic<Table*> current;
+        std::atomic<std::uint64_t> version {1};
+
+        std::unique_ptr<Slot[]> slots;
+        std::size_t slotsCnt;
+
+        std::mutex writeMutex;
+    };
+}
+
+#endif
@@ -2,16 +2,31 @@
 #define MY_stackImplH_GUARD
 
 #include "dynamic_array.h"
+#include "small_dynamic_array.h"
 
 namespace data_struct
 {
-    template <typename T>
+    // Container - DynamicArray или SmallDynamicArray с тем же Alloc
+    template <typename T, typename Alloc = std::allocator<T>, typename Container = DynamicArray<T, Alloc>>
     class Stack {
+        static_assert (std::is_same_v<typename Container::allocator_type, Alloc>, "у Container должен быть тот же Alloc");
+
     public:
-        using iterator       = typename DynamicArray<T>::iterator;
-        using const_iterator = typename DynamicArray<T>::const_iterator;
+        using iterator       = typename Container::iterator;
+        using const_iterator = typename Container::const_iterator;
+        using allocator_type = Alloc;
 
     public:
+        Stack() noexcept (std::is_nothrow_default_constructible_v<Alloc>) = default;
+
+        explicit Stack (Alloc const& alloc) noexcept
+            : stackImpl (alloc)
+        {}
+
+        allocator_type get_allocator() const noexcept {
+            return stackImpl.get_allocator();
+        }
+
         auto begin() const noexcept {
             return stackImpl.cbegin();
         }
@@ -65,16 +80,32 @@ namespace data_struct
             stackImpl.reserve (newCapacity);
         }
 
+        void swap (Stack& rhs) noexcept (noexcept (std::declval<Container&>().swap (std::declval<Container&>()))) {
+            stackImpl.swap (rhs.stackImpl);
+        }
+
     private:
-        DynamicArray<T> stackImpl;
+        Container stackImpl;
     };
 
 
-    template <typename T>
-    void swap (Stack<T>& lhs, Stack<T>& rhs)
+    template <typename T, typename Alloc, typename Container>
+    void swap (Stack<T, Alloc, Container>& lhs, Stack<T, Alloc, Container>& rhs)
     {
         lhs.swap(rhs);
     }
+
+
+    // до N элементов стек не обращается к куче
+    template <typename T, std::size_t N, typename Alloc = std::allocator<T>>
+    using SmallStack = Stack<T, Alloc, SmallDynamicArray<T, N, Alloc>>;
+
+
+    namespace pmr
+    {
+        template <typename T>
+        using Stack = data_struct::Stack<T, std::pmr::polymorphic_allocator<T>>;
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,416 @@
+#ifndef MY_STRING_HASH_TABLE_H_GUARD
+#define MY_STRING_HASH_TABLE_H_GUARD
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include "dynamic_array.h"
+#include "flat_hash_set.h"
+
+namespace string_detail
+{
+    // байты длинных ключей: блоки растут вдвое до maxBlock, строки в блоке
+    // идут подряд. Адреса не меняются до уничтожения арены
+    class StringArena {
+        static constexpr std::size_t minBlock = 4096;
+        static constexpr std::size_t maxBlock = 1 << 20;
+
+    public:
+        StringArena() noexcept = default;
+
+        StringArena (StringArena&& rhs) noexcept
+            : blocks (std::move (rhs.blocks))
+            , cur (std::exchange (rhs.cur, nullptr))
+            , left (std::exchange (rhs.left, 0))
+            , bytes_ (std::exchange (rhs.bytes_, 0))
+        {}
+
+        StringArena& operator= (StringArena&& rhs) noexcept {
+            if (this != &rhs) {
+                auto tmp {std::move (rhs)};
+                swap (tmp);
+            }
+            return *this;
+        }
+
+        StringArena (StringArena const&) = delete;
+        StringArena& operator= (StringArena const&) = delete;
+
+        ~StringArena() noexcept {
+            for (std::size_t i = 0; i < blocks.size(); ++i) {
+                ::operator delete (blocks[i]);
+            }
+        }
+
+        void swap (StringArena& rhs) noexcept {
+            blocks.swap (rhs.blocks);
+            std::swap (cur, rhs.cur);
+            std::swap (left, rhs.left);
+            std::swap (bytes_, rhs.bytes_);
+        }
+
+        char const* store (std::string_view str) {
+            if (str.size() > left) {
+                add_block (str.size());
+            }
+
+            auto res = cur;
+            std::memcpy (cur, str.data(), str.size());
+            cur += str.size();
+            left -= str.size();
+            return res;
+        }
+
+        // выделено под блоки
+        std::size_t bytes() const noexcept {
+            return bytes_;
+        }
+
+    private:
+        void add_block (std::size_t needed) {
+            auto size = blocks.empty() ? minBlock : bytes_;
+            if (size > maxBlock) {
+                size = maxBlock;
+            }
+            if (size < needed) {
+                size = needed;
+            }
+
+            blocks.reserve (blocks.size() + 1);
+            cur = static_cast<char*> (::operator new (size));
+            blocks.push_back (cur);
+
+            left = size;
+            bytes_ += size;
+        }
+
+    private:
+        data_struct::DynamicArray<char*> blocks;
+        char* cur = nullptr;
+        std::size_t left = 0;
+        std::size_t bytes_ = 0;
+    };
+
+
+    // ключ в ячейке таблицы, 24 байта: старшая половина хеша, длина и сами
+    // байты, если их не больше inlineCapacity, иначе указатель в арену.
+    // Сравнение с искомой строкой начинается с хеша и длины, до байтов
+    // доходит почти только при совпадении
+    class StringKey {
+    public:
+        static constexpr std::size_t inlineCapacity = 16;
+
+    public:
+        StringKey (std::string_view str, std::size_t hash, StringArena& arena)
+            : tag (tag_of (hash))
+            , size_ (std::uint32_t (str.size()))
+        {
+            if (str.size() > UINT32_MAX) throw std::runtime_error (
+                "слишком длинный ключ StringHashTable\n"
+            );
+
+            if (str.size() <= inlineCapacity) {
+                std::memcpy (bytes, str.data(), str.size());
+            } else {
+                auto ptr = arena.store (str);
+                std::memcpy (bytes, &ptr, sizeof(ptr));
+            }
+        }
+
+        std::string_view view() const noexcept {
+            return {data(), size_};
+        }
+
+        operator std::string_view() const noexcept {
+            return view();
+        }
+
+        char const* data() const noexcept {
+            if (size_ <= inlineCapacity)
+                return bytes;
+
+            char const* ptr;
+            std::memcpy (&ptr, bytes, sizeof(ptr));
+            return ptr;
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        bool equal (std::string_view str, std::size_t hash) const noexcept {
+            return tag == tag_of (hash)
+               and size_ == str.size()
+               and std::memcmp (data(), str.data(), size_) == 0;
+        }
+
+        friend bool operator== (StringKey const& lhs, std::string_view rhs) noexcept {
+            return lhs.view() == rhs;
+        }
+
+        friend bool operator== (std::string_view lhs, StringKey const& rhs) noexcept {
+            return lhs == rhs.view();
+        }
+
+    private:
+        // младшие биты хеша уже выбрали группу и управляющий байт
+        static
+        std::uint32_t tag_of (std::size_t hash) noexcept {
+            return std::uint32_t (std::uint64_t (hash) >> 32);
+        }
+
+    private:
+        std::uint32_t tag;
+        std::uint32_t size_;
+        char bytes[inlineCapacity];
+    };
+
+
+    template <typename Value>
+    struct Entry {
+        StringKey first;
+        Value second;
+    };
+
+
+    // искомая строка вместе с уже посчитанным хешем
+    struct Probe {
+        std::string_view str;
+        std::size_t hash;
+    };
+
+
+    // при росте таблицы хеш считается заново по байтам ключа:
+    // для коротких ключей это дешевле, чем хранить его в каждой ячейке
+    template <typename Hash>
+    struct EntryHash {
+        using is_transparent = void;
+
+        template <typename Value>
+        std::size_t operator() (Entry<Value> const& entry) const noexcept {
+            return hasher (entry.first.view());
+        }
+
+        std::size_t operator() (Probe const& probe) const noexcept {
+            return probe.hash;
+        }
+
+        Hash hasher{};
+    };
+
+
+    struct EntryEqual {
+        using is_transparent = void;
+
+        template <typename Value>
+        bool operator() (Entry<Value> const& lhs, Entry<Value> const& rhs) const noexcept {
+            return lhs.first.view() == rhs.first.view();
+        }
+
+        template <typename Value>
+        bool operator() (Probe const& probe, Entry<Value> const& entry) const noexcept {
+            return entry.first.equal (probe.str, probe.hash);
+        }
+    };
+}
+
+
+namespace data_struct
+{
+    // таблица со строковыми ключами: ключи до 16 байт лежат прямо в ячейке,
+    // длинные - в общей арене, без отдельной аллокации на ключ. Поиск по
+    // std::string_view без создания строк.
+    // Байты удалённых длинных ключей остаются в арене до shrink_to_fit или
+    // копирования - копия собирает ключи заново
+    template <
+        typename Value
+      , typename Hash = Hasher<std::string_view>
+      , typename Policy = FlatHashPolicy
+    >
+    class StringHashTable {
+        using Elem = string_detail::Entry<Value>;
+        using Probe = string_detail::Probe;
+        using EntryHash = string_detail::EntryHash<Hash>;
+        using Impl = FlatHashSet<Elem, EntryHash, string_detail::EntryEqual, Policy>;
+
+    public:
+        using iterator       = KeyValueIterator<typename Impl::iterator, typename Impl::const_iterator>;
+        using const_iterator = typename Impl::const_iterator;
+
+    public:
+        StringHashTable() noexcept = default;
+
+        explicit StringHashTable (Hash const& hash)
+            : hasher (hash)
+            , impl (EntryHash {hash})
+        {}
+
+        StringHashTable (StringHashTable&&) noexcept = default;
+
+        StringHashTable (StringHashTable const& rhs)
+            : StringHashTable (rhs.hasher)
+        {
+            impl.reserve (rhs.size());
+            for (auto& el : rhs) {
+                auto hash = hasher (el.first);
+
+                impl.lazy_emplace (Probe {el.first, hash}, [&] {
+                    return Elem {{el.first, hash, arena}, el.second};
+                });
+            }
+        }
+
+        StringHashTable& operator= (StringHashTable&& rhs) noexcept {
+            if (this != &rhs) {
+                auto tmp {std::move (rhs)};
+                swap (tmp);
+            }
+            return *this;
+        }
+
+        StringHashTable& operator= (StringHashTable const& rhs) {
+            if (this != &rhs) {
+                auto tmp {rhs};
+                swap (tmp);
+            }
+            return *this;
+        }
+
+        ~StringHashTable() noexcept = default;
+
+        void swap (StringHashTable& rhs) noexcept {
+            std::swap (hasher, rhs.hasher);
+            arena.swap (rhs.arena);
+            impl.swap (rhs.impl);
+        }
+
+        bool empty() const noexcept {
+            return impl.empty();
+        }
+
+        std::size_t size() const noexcept {
+            return impl.size();
+        }
+
+        std::size_t bucket_count() const noexcept {
+            return impl.bucket_count();
+        }
+
+        float load_factor() const noexcept {
+            return impl.load_factor();
+        }
+
+        void reserve (std::size_t count) {
+            impl.reserve (count);
+        }
+
+        // заодно освобождает в арене место удалённых ключей
+        void shrink_to_fit() {
+            auto tmp {*this};
+            swap (tmp);
+        }
+
+        // elementsBytes включает арену
+        HashStats stats() const {
+            auto res = impl.stats();
+            res.elementsBytes += arena.bytes();
+            return res;
+        }
+
+        auto cbegin() const noexcept {
+            return impl.cbegin();
+        }
+
+        auto begin() const noexcept {
+            return cbegin();
+        }
+
+        auto cend() const noexcept {
+            return impl.cend();
+        }
+
+        auto end() const noexcept {
+            return cend();
+        }
+
+        Pair<iterator, bool> add (std::string_view key, Value const& value = Value{}) {
+            return try_emplace (key, value);
+        }
+
+        // значение строится, а ключ копируется, только если ключа ещё нет
+        template <typename... Ts>
+        Pair<iterator, bool> try_emplace (std::string_view key, Ts&&... params) {
+            auto hash = hasher (key);
+
+            auto res = impl.lazy_emplace (Probe {key, hash}, [&] {
+                return Elem {{key, hash, arena}, Value {std::forward<Ts> (params)...}};
+            });
+            return {res.first, res.second};
+        }
+
+        template <typename V>
+        Pair<iterator, bool> insert_or_assign (std::string_view key, V&& value) {
+            auto hash = hasher (key);
+
+            auto res = impl.lazy_emplace (Probe {key, hash}, [&] {
+                return Elem {{key, hash, arena}, Value {std::forward<V> (value)}};
+            });
+
+            if (not res.second) {
+                res.first->second = std::forward<V> (value);
+            }
+            return {res.first, res.second};
+        }
+
+        void erase (std::string_view key) {
+            impl.erase (Probe {key, hasher (key)});
+        }
+
+        iterator find (std::string_view key) {
+            return impl.find (Probe {key, hasher (key)});
+        }
+
+        const_iterator find (std::string_view key) const {
+            return impl.find (Probe {key, hasher (key)});
+        }
+
+        bool contains (std::string_view key) const {
+            return find (key) != end();
+        }
+
+        Value& operator[] (std::string_view key) {
+            return get (key);
+        }
+
+        Value const& operator[] (std::string_view key) const {
+            return get (key);
+        }
+
+    private:
+        Value& get (std::string_view key) const {
+            auto it = find (key);
+
+            if (it == end()) throw std::runtime_error (
+                "не существует элемента с таким ключом\n"
+            );
+
+            return const_cast<Value&> (it->second);
+        }
+
+    private:
+        Hash hasher{};
+        string_detail::StringArena arena;
+        Impl impl{};
+    };
+
+
+    template <typename Value, typename Hash, typename Policy>
+    void swap (StringHashTable<Value, Hash, Policy>& lhs, StringHashTable<Value, Hash, Policy>& rhs) noexcept {
+        lhs.swap (rhs);
+    }
+}
+
+#endif